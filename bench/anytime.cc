@@ -0,0 +1,105 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file anytime.cc
+ * @brief Checks of the anytime solvers
+ *        Usage: anytime
+ *        Runs the solvers of solver.h on a seeded uniform instance large
+ *        enough for the distance matrix to take longer than the deadline,
+ *        and fails if a run ends well after it or without a solution. Then
+ *        polls best() from another thread during an unbounded run, cancels
+ *        it and fails if the run does not stop soon with that solution or
+ *        a better one
+*/
+
+#include <iostream>
+#include <string>
+#include <optional>
+#include <climits>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <future>
+
+#include "solver.h"
+#include "instance-generator.h"
+
+// Margen sobre el plazo: evaluar la solución final es O(n·k) y no se interrumpe
+const std::chrono::milliseconds kDeadline{50};
+const std::chrono::milliseconds kTolerance{100};
+
+/**
+ * @brief Solves with a deadline and checks the time and the solution
+ * @return Whether the check passed
+ */
+bool check_deadline(const std::string& name, Solver& solver, const Problem& problem, int k) {
+  SolverControl control;
+  auto start = std::chrono::steady_clock::now();
+  control.deadline = start + kDeadline;
+  SolverResult result = solver.solve(problem, k, control);
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  bool passed = elapsed < kDeadline + kTolerance && result.solution.size() > 0;
+  std::cout << (passed ? "ok   " : "FAIL ") << name << " deadline " << kDeadline.count() << " ms: "
+            << elapsed.count() << " ms, objective " << result.value << std::endl;
+  return passed;
+}
+
+/**
+ * @brief Reads best() while another thread solves, then cancels the run
+ * @return Whether the check passed
+ */
+bool check_cancellation(const std::string& name, Solver& solver, const Problem& problem, int k) {
+  SolverControl control;
+  std::future<SolverResult> run = std::async(std::launch::async, [&]() { return solver.solve(problem, k, control); });
+  std::optional<SolverResult> seen;
+  while (!(seen = solver.best())) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto cancelled = std::chrono::steady_clock::now();
+  control.cancellation.cancel();
+  SolverResult result = run.get();
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - cancelled;
+  bool passed = elapsed < kTolerance && seen->solution.size() > 0 && result.value <= seen->value;
+  std::cout << (passed ? "ok   " : "FAIL ") << name << " cancelled after best() " << seen->value << ": "
+            << elapsed.count() << " ms, objective " << result.value << std::endl;
+  return passed;
+}
+
+int main() {
+  const int m{12000};
+  Problem problem = generate_uniform(m, 4, 42);
+  int k = m / 10;
+  bool passed{true};
+
+  GraspOptions grasp;
+  grasp.seed = 42;
+  GraspSolver grasp_solver(grasp);
+  passed = check_deadline("grasp", grasp_solver, problem, k) && passed;
+
+  GVNSOptions gvns;
+  gvns.seed = 42;
+  GVNSSolver gvns_solver(gvns);
+  passed = check_deadline("gvns", gvns_solver, problem, k) && passed;
+
+  KMeansOptions kmeans;
+  kmeans.seed = 42;
+  KMeansSolver kmeans_solver(kmeans);
+  passed = check_deadline("kmeans", kmeans_solver, problem, k) && passed;
+
+  // Sin más límite que la cancelación
+  Problem small = generate_uniform(2000, 4, 42);
+  gvns.max_iterations = INT_MAX;
+  gvns.max_iterations_without_improvement = INT_MAX;
+  GVNSSolver unbounded_gvns(gvns);
+  passed = check_cancellation("gvns", unbounded_gvns, small, small.size() / 10) && passed;
+  grasp.max_iterations_without_improvement = INT_MAX;
+  GraspSolver unbounded_grasp(grasp);
+  passed = check_cancellation("grasp", unbounded_grasp, small, small.size() / 10) && passed;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file problem_storage.cc
+ * @brief Problem storage benchmark
+ *        Usage: problem_storage [m] [n] [temporary_instance_path]
+ *        Compares the legacy vector-of-vectors point storage with the
+ *        contiguous Problem buffer: heap usage of the storage, load time of
+ *        a text instance and a distance sweep over all the points
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "problem.h"
+
+// Contadores de memoria dinámica de todo el programa
+static size_t allocations{0};
+static size_t allocated_bytes{0};
+
+void* operator new(size_t size) {
+  ++allocations;
+  allocated_bytes += size;
+  void* memory = std::malloc(size);
+  if (memory == nullptr) throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  ++allocations;
+  allocated_bytes += size;
+  size_t align = static_cast<size_t>(alignment);
+  void* memory = std::aligned_alloc(align, (size + align - 1) / align * align);
+  if (memory == nullptr) throw std::bad_alloc();
+  return memory;
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+
+typedef std::vector<Point> LegacyProblem;
+
+struct Measure {
+  double seconds;
+  size_t allocations;
+  size_t bytes;
+};
+
+template <typename Load>
+Measure measure(Load load) {
+  size_t start_allocations{allocations};
+  size_t start_bytes{allocated_bytes};
+  auto start = std::chrono::high_resolution_clock::now();
+  load();
+  auto end = std::chrono::high_resolution_clock::now();
+  return {std::chrono::duration<double>(end - start).count(),
+          allocations - start_allocations, allocated_bytes - start_bytes};
+}
+
+LegacyProblem loadLegacy(const std::string& path) {
+  std::ifstream file(path);
+  int m, n;
+  file >> m >> n;
+  LegacyProblem problem;
+  for (int i{0}; i < m; ++i) {
+    problem.push_back(Point(n));
+  }
+  for (int i{0}; i < m; ++i) {
+    for (int j{0}; j < n; ++j) {
+      file >> problem[i][j];
+    }
+  }
+  return problem;
+}
+
+Problem loadContiguous(const std::string& path) {
+  std::ifstream file(path);
+  int m, n;
+  file >> m >> n;
+  Problem problem(m, n);
+  for (int i{0}; i < m; ++i) {
+    for (int j{0}; j < n; ++j) {
+      file >> problem[i][j];
+    }
+  }
+  return problem;
+}
+
+void print(const std::string& name, const Measure& storage, const Measure& load, double sweep) {
+  std::cout << name << "," << storage.allocations << "," << storage.bytes << ","
+            << storage.seconds << "," << load.seconds << "," << sweep << std::endl;
+}
+
+int main(int argc, char** argv) {
+  int m = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int n = argc > 2 ? std::atoi(argv[2]) : 64;
+
+  // Instancia sintética en el formato de examples/
+  std::string path = argc > 3 ? argv[3] : "problem_storage_bench.txt";
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<> dis(0.0, 10.0);
+  {
+    std::ofstream instance(path);
+    instance << m << "\n" << n << "\n";
+    for (int i{0}; i < m; ++i) {
+      for (int j{0}; j < n; ++j) {
+        instance << dis(gen) << (j + 1 < n ? " " : "\n");
+      }
+    }
+  }
+
+  // La lectura con operator>> reserva memoria por cada número, así que la
+  // memoria del almacenamiento se mide aparte de la carga completa
+  Measure legacy_storage = measure([&]() {
+    LegacyProblem problem;
+    for (int i{0}; i < m; ++i) {
+      problem.push_back(Point(n));
+    }
+  });
+  Measure contiguous_storage = measure([&]() { Problem problem(m, n); });
+
+  LegacyProblem legacy;
+  Problem contiguous(0, n);
+  Measure legacy_load = measure([&]() { legacy = loadLegacy(path); });
+  Measure contiguous_load = measure([&]() { contiguous = loadContiguous(path); });
+  std::remove(path.c_str());
+
+  // Recorrido de distancias de cada punto al primero
+  double checksum{0};
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i{0}; i < m; ++i) {
+    checksum += euclidean_distance(legacy[i], legacy[0]);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double legacy_sweep = std::chrono::duration<double>(end - start).count();
+  start = std::chrono::high_resolution_clock::now();
+  for (int i{0}; i < m; ++i) {
+    checksum -= euclidean_distance(contiguous[i], contiguous[0]);
+  }
+  end = std::chrono::high_resolution_clock::now();
+  double contiguous_sweep = std::chrono::duration<double>(end - start).count();
+
+  std::cout << "m=" << m << ",n=" << n << ",checksum=" << checksum << std::endl;
+  std::cout << "Almacenamiento,Reservas,Bytes,Reserva(s),Carga(s),Recorrido(s)" << std::endl;
+  print("vector<Point>", legacy_storage, legacy_load, legacy_sweep);
+  print("Problem", contiguous_storage, contiguous_load, contiguous_sweep);
+  return 0;
+}
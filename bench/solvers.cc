@@ -0,0 +1,232 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file solvers.cc
+ * @brief Solver benchmark suite
+ *        Usage: solvers [--full] [--format csv|json] [--output <file>]
+ *                       [--warmup <runs>] [--repetitions <runs>]
+ *                       [--seed <seed>] [--filter <text>]
+ *        Runs every solver on seeded uniform and Gaussian blob instances of
+ *        several sizes, on one thread and with fixed seeds, so two commits
+ *        can be compared run against run. Reports the median and p95 time,
+ *        the throughput in points per second and the objective reached.
+ *        Built with make INSTRUMENT=1, it also writes the phase report of
+ *        every case to the standard error
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "k-means.h"
+#include "grasp.h"
+#include "gvns.h"
+#include "instance-generator.h"
+
+struct Case {
+  std::string name;       // Algoritmo y variante
+  std::string instance;   // "uniform" o "blobs"
+  int m, d, k;
+  std::function<double(const Problem&, const FloatProblem&, unsigned)> run;  // Devuelve el objetivo
+};
+
+struct Result {
+  const Case* test;
+  std::vector<double> seconds;
+  double objective;
+};
+
+std::vector<Case> cases(bool full) {
+  std::vector<Case> suite;
+  auto kmeans = [](KMeansAssignment assignment, bool single) {
+    return [assignment, single](const Problem& problem, const FloatProblem& float_problem, unsigned seed) {
+      KMeansOptions options;
+      options.seed = seed;
+      options.assignment = assignment;
+      options.initialization = KMeansInitialization::kPlusPlus;
+      int k = problem.size() / 10 < 2 ? 2 : problem.size() / 10;
+      KMeans algorithm(options);
+      Solution solution = single ? algorithm.solve(float_problem, k).back() : algorithm.solve(problem, k).back();
+      return solution.evaluate(problem);
+    };
+  };
+  std::vector<std::pair<std::string, KMeansAssignment>> assignments{
+      {"kmeans-lloyd", KMeansAssignment::kLloyd},
+      {"kmeans-hamerly", KMeansAssignment::kHamerly},
+      {"kmeans-indexed", KMeansAssignment::kIndexed},
+      {"kmeans-blocked", KMeansAssignment::kBlocked},
+      {"kmeans-lloyd-f32", KMeansAssignment::kLloyd},
+      {"kmeans-hamerly-f32", KMeansAssignment::kHamerly},
+      {"kmeans-blocked-f32", KMeansAssignment::kBlocked}};
+  std::vector<int> kmeans_sizes{2000, 10000};
+  std::vector<int> dimensions{2, 16, 64};
+  if (full) {
+    kmeans_sizes.push_back(50000);
+    dimensions.push_back(256);
+  }
+  for (const auto& assignment: assignments) {
+    for (int m: kmeans_sizes) {
+      for (int d: dimensions) {
+        for (const char* instance: {"uniform", "blobs"}) {
+          bool single = assignment.first.find("-f32") != std::string::npos;
+          suite.push_back({assignment.first, instance, m, d, m / 10, kmeans(assignment.second, single)});
+        }
+      }
+    }
+  }
+
+  // Las metaheurísticas se acotan en iteraciones para que cada ejecución dure poco
+  std::vector<int> search_sizes{200, 400};
+  if (full) search_sizes.push_back(1000);
+  auto grasp = [](LocalSearchOptions local_search) {
+    return [local_search](const Problem& problem, const FloatProblem&, unsigned seed) {
+      GraspOptions options;
+      options.seed = seed;
+      options.max_iterations_without_improvement = 10;
+      options.local_search = local_search;
+      return Grasp(options).solve(problem, problem.size() / 10, 3).back().evaluate(problem);
+    };
+  };
+  auto gvns = [](bool rvnd) {
+    return [rvnd](const Problem& problem, const FloatProblem&, unsigned seed) {
+      GVNSOptions options;
+      options.seed = seed;
+      options.max_iterations_without_improvement = 10;
+      options.max_iterations = 5;
+      return GVNS(options).solve(problem, problem.size() / 10, rvnd).back().evaluate(problem);
+    };
+  };
+  LocalSearchOptions first;
+  first.strategy = LocalSearchStrategy::kFirstImprovement;
+  LocalSearchOptions candidates;
+  candidates.candidate_list_size = 10;
+  LocalSearchOptions fastest{first};
+  fastest.candidate_list_size = 10;
+  for (int m: search_sizes) {
+    for (int d: {2, 16}) {
+      for (const char* instance: {"uniform", "blobs"}) {
+        suite.push_back({"grasp", instance, m, d, m / 10, grasp(LocalSearchOptions())});
+        suite.push_back({"grasp-first", instance, m, d, m / 10, grasp(first)});
+        suite.push_back({"grasp-cl10", instance, m, d, m / 10, grasp(candidates)});
+        suite.push_back({"grasp-first-cl10", instance, m, d, m / 10, grasp(fastest)});
+        suite.push_back({"gvns", instance, m, d, m / 10, gvns(false)});
+        suite.push_back({"gvns-rvnd", instance, m, d, m / 10, gvns(true)});
+      }
+    }
+  }
+  return suite;
+}
+
+/**
+ * @brief Value below which a fraction q of the sorted samples fall (nearest rank)
+ */
+double percentile(std::vector<double> samples, double q) {
+  std::sort(samples.begin(), samples.end());
+  int rank = std::ceil(q * samples.size());
+  return samples[std::max(0, std::min<int>(samples.size(), rank) - 1)];
+}
+
+void write_csv(std::ostream& os, const std::vector<Result>& results) {
+  os << "name,instance,m,d,k,runs,median_s,p95_s,points_per_s,objective" << std::endl;
+  for (const Result& result: results) {
+    double median = percentile(result.seconds, 0.5);
+    os << result.test->name << "," << result.test->instance << "," << result.test->m << "," << result.test->d << ","
+       << result.test->k << "," << result.seconds.size() << "," << median << "," << percentile(result.seconds, 0.95)
+       << "," << result.test->m / median << "," << result.objective << std::endl;
+  }
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results, unsigned seed) {
+  os << "{\"seed\": " << seed << ", \"results\": [" << std::endl;
+  for (size_t r{0}; r < results.size(); ++r) {
+    const Result& result = results[r];
+    double median = percentile(result.seconds, 0.5);
+    os << "  {\"name\": \"" << result.test->name << "\", \"instance\": \"" << result.test->instance
+       << "\", \"m\": " << result.test->m << ", \"d\": " << result.test->d << ", \"k\": " << result.test->k
+       << ", \"runs\": " << result.seconds.size() << ", \"median_s\": " << median
+       << ", \"p95_s\": " << percentile(result.seconds, 0.95) << ", \"points_per_s\": " << result.test->m / median
+       << ", \"objective\": " << result.objective << "}" << (r + 1 < results.size() ? "," : "") << std::endl;
+  }
+  os << "]}" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  bool full{false};
+  std::string format{"csv"};
+  std::string output;
+  int warmup{1};
+  int repetitions{5};
+  unsigned seed{42};
+  std::string filter;
+  for (int a{1}; a < argc; ++a) {
+    std::string argument = argv[a];
+    bool has_value = a + 1 < argc;
+    if (argument == "--full") {
+      full = true;
+    } else if (argument == "--format" && has_value) {
+      format = argv[++a];
+    } else if (argument == "--output" && has_value) {
+      output = argv[++a];
+    } else if (argument == "--warmup" && has_value) {
+      warmup = std::atoi(argv[++a]);
+    } else if (argument == "--repetitions" && has_value) {
+      repetitions = std::max(1, std::atoi(argv[++a]));
+    } else if (argument == "--seed" && has_value) {
+      seed = std::strtoul(argv[++a], nullptr, 10);
+    } else if (argument == "--filter" && has_value) {
+      filter = argv[++a];
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--full] [--format csv|json] [--output <file>] [--warmup <runs>]"
+                << " [--repetitions <runs>] [--seed <seed>] [--filter <text>]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<Case> suite = cases(full);
+  std::vector<Result> results;
+  for (const Case& test: suite) {
+    if (!filter.empty() && test.name.find(filter) == std::string::npos) continue;
+    // La instancia solo depende de la semilla y de su tamaño
+    unsigned instance_seed = seed ^ (unsigned(test.m) * 2654435761u) ^ (unsigned(test.d) << 20);
+    Problem problem = test.instance == "uniform" ? generate_uniform(test.m, test.d, instance_seed)
+                                                 : generate_blobs(test.m, test.d, test.k, instance_seed);
+    problem.build_norms();
+    FloatProblem float_problem(problem);
+    float_problem.build_norms();
+    Result result{&test, {}, 0};
+    for (int run{0}; run < warmup + repetitions; ++run) {
+      auto start = std::chrono::high_resolution_clock::now();
+      result.objective = test.run(problem, float_problem, seed);
+      auto end = std::chrono::high_resolution_clock::now();
+      if (run >= warmup) result.seconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    std::cerr << test.name << " " << test.instance << " m=" << test.m << " d=" << test.d << " "
+              << percentile(result.seconds, 0.5) << "s" << std::endl;
+    if (instrumentation::kEnabled) {  // Totales de todas las ejecuciones del caso, calentamiento incluido
+      instrumentation::write_report(std::cerr);
+      instrumentation::Registry::instance().reset();
+    }
+    results.push_back(result);
+  }
+
+  std::ofstream file;
+  if (!output.empty()) file.open(output);
+  std::ostream& os = output.empty() ? std::cout : file;
+  if (format == "json") {
+    write_json(os, results, seed);
+  } else {
+    write_csv(os, results);
+  }
+  return 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file batch-runner.h
+ * @brief BatchRunner class
+ *        This class runs every algorithm on every instance of a sweep as
+ *        independent jobs on a thread pool
+ */
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <sstream>
+#include <ostream>
+#include <algorithm>
+#include <optional>
+#include "solver.h"
+#include "instance-io.h"
+#include "thread-pool.h"
+
+enum class BatchAlgorithm { kKMeans, kGrasp, kGVNS };
+
+/**
+ * @brief Options of a sweep. The options of each algorithm are used as
+ *        given except for their threads: every job runs on one thread
+*/
+struct BatchOptions {
+  int threads{0};      // Trabajos simultáneos (0 = todos los núcleos)
+  int repetitions{5};  // Ejecuciones de cada algoritmo en cada instancia
+  int lrc_size{3};     // |LRC| de GRASP
+  bool rvnd{true};     // Búsqueda local de GVNS por RVND
+  bool debug{false};   // Escribir también los puntos de cada solución
+  bool single_precision{false};  // K-Means sobre una copia float de cada instancia
+  std::optional<double> time_limit;  // Segundos de reloj de cada ejecución
+  size_t matrix_budget{size_t(1) << 30};  // Bytes de todas las matrices de distancias compartidas
+  std::vector<BatchAlgorithm> algorithms{BatchAlgorithm::kKMeans, BatchAlgorithm::kGrasp, BatchAlgorithm::kGVNS};
+  KMeansOptions kmeans;
+  GraspOptions grasp;
+  GVNSOptions gvns;
+};
+
+/**
+ * @brief Loads every instance once and shares it read-only with all its
+ *        jobs, one per (instance, algorithm, repetition), together with its
+ *        distance matrix when GRASP or GVNS would build one: the matrices of
+ *        all instances share matrix_budget, and the searches of an instance
+ *        left without one compute their distances directly. The jobs start
+ *        from the most expensive one, so the long ones do not end up alone
+ *        at the end of the sweep, and each result line is written as soon
+ *        as its job finishes
+*/
+class BatchRunner {
+ public:
+  BatchRunner(const BatchOptions& options = BatchOptions()) : options_(options) {}
+
+  /**
+   * @brief Header of the CSV lines written by run()
+  */
+  static const char* header() {
+    return "Algoritmo,Problema,m,k,|LRC|/kmax,Ejecución,SSE,CPU(s)";
+  }
+
+  /**
+   * @brief Runs the sweep and writes one CSV line per job, in the order the
+   *        jobs finish
+  */
+  void run(const std::vector<std::string>& instance_paths, std::ostream& out) {
+    std::vector<std::shared_ptr<const Problem>> problems;
+    std::vector<std::shared_ptr<const FloatProblem>> float_problems(instance_paths.size());
+    bool float_kmeans = options_.single_precision &&
+        std::count(options_.algorithms.begin(), options_.algorithms.end(), BatchAlgorithm::kKMeans) > 0;
+    for (int instance{0}; instance < int(instance_paths.size()); ++instance) {
+      // Las normas se calculan antes de compartir la instancia entre los hilos
+      std::shared_ptr<Problem> problem = std::make_shared<Problem>(load_instance(instance_paths[instance]));
+      problem->build_norms();
+      problems.push_back(problem);
+      if (float_kmeans) {
+        std::shared_ptr<FloatProblem> float_problem = std::make_shared<FloatProblem>(*problem);
+        float_problem->build_norms();
+        float_problems[instance] = float_problem;
+      }
+    }
+    // El pool construye las matrices y después reparte los trabajos
+    ThreadPool pool(options_.threads);
+    matrices_.assign(problems.size(), nullptr);
+    size_t matrix_bytes{0};
+    for (int instance{0}; instance < int(problems.size()); ++instance) {
+      size_t bytes = DistanceMatrix::bytes(problems[instance]->size());
+      if (needs_matrix() && problems[instance]->size() > 1 && matrix_bytes + bytes <= options_.matrix_budget) {
+        matrices_[instance] = std::make_shared<const DistanceMatrix>(*problems[instance], pool);
+        matrix_bytes += bytes;
+      }
+    }
+    std::vector<Job> jobs;
+    for (int instance{0}; instance < int(problems.size()); ++instance) {
+      const Problem& problem = *problems[instance];
+      int k = problem.size() / 10 < 2 ? 2 : problem.size() / 10;
+      for (BatchAlgorithm algorithm: options_.algorithms) {
+        // Coste estimado: Lloyd es O(m·k·n); la búsqueda local de la p-mediana, O(m²·n)
+        double cost = double(problem.size()) * problem.dimensions() *
+                      (algorithm == BatchAlgorithm::kKMeans ? k : problem.size());
+        for (int repetition{1}; repetition <= options_.repetitions; ++repetition) {
+          jobs.push_back({instance, algorithm, repetition, k, cost});
+        }
+      }
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.cost > b.cost; });
+
+    // El pool reparte los trabajos en orden de índice a medida que los hilos quedan libres
+    std::mutex out_mutex;
+    pool.parallel_for(jobs.size(), [&](int index) {
+      const Job& job = jobs[index];
+      std::string line = run_job(job, *problems[job.instance], float_problems[job.instance].get(),
+                                 instance_paths[job.instance]);
+      std::lock_guard<std::mutex> lock(out_mutex);
+      out << line << std::flush;
+    });
+  }
+
+ private:
+  struct Job {
+    int instance;
+    BatchAlgorithm algorithm;
+    int repetition;
+    int k;
+    double cost;
+  };
+
+  BatchOptions options_;
+  std::vector<std::shared_ptr<const DistanceMatrix>> matrices_;  // Por instancia, o null
+
+  static bool uses_matrix(const DistanceOptions& distances) {
+    return distances.backend == DistanceBackend::kAuto || distances.backend == DistanceBackend::kMatrix;
+  }
+
+  /**
+   * @brief Whether some p-median algorithm of the sweep would build a matrix
+  */
+  bool needs_matrix() const {
+    for (BatchAlgorithm algorithm: options_.algorithms) {
+      if ((algorithm == BatchAlgorithm::kGrasp && uses_matrix(options_.grasp.distances)) ||
+          (algorithm == BatchAlgorithm::kGVNS && uses_matrix(options_.gvns.distances))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Gives a job the matrix of its instance, so that it does not build
+   *        its own copy; without one, the job computes the distances directly
+  */
+  void share_matrix(DistanceOptions& distances, int instance) const {
+    if (!uses_matrix(distances)) return;
+    distances.matrix = matrices_[instance];
+    if (!distances.matrix) distances.backend = DistanceBackend::kDirect;
+  }
+
+  std::string run_job(const Job& job, const Problem& problem, const FloatProblem* float_problem,
+                      const std::string& path) {
+    auto start = std::chrono::high_resolution_clock::now();
+    SolverControl control;
+    if (options_.time_limit) {
+      control.deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::duration<double>(*options_.time_limit));
+    }
+    std::unique_ptr<Solver> solver;
+    std::string name;
+    std::string parameter;  // |LRC| de GRASP, kmax de GVNS
+    switch (job.algorithm) {
+      case BatchAlgorithm::kKMeans: {
+        KMeansOptions options = options_.kmeans;
+        options.threads = 1;
+        solver = std::make_unique<KMeansSolver>(options, float_problem);
+        name = float_problem ? "K-Means-f32" : "K-Means";
+        break;
+      }
+      case BatchAlgorithm::kGrasp: {
+        GraspOptions options = options_.grasp;
+        options.threads = 1;
+        share_matrix(options.distances, job.instance);
+        solver = std::make_unique<GraspSolver>(options, options_.lrc_size);
+        name = "GRASP";
+        parameter = std::to_string(options_.lrc_size);
+        break;
+      }
+      case BatchAlgorithm::kGVNS: {
+        GVNSOptions options = options_.gvns;
+        options.threads = 1;
+        share_matrix(options.distances, job.instance);
+        solver = std::make_unique<GVNSSolver>(options, options_.rvnd);
+        name = "GVNS";
+        parameter = std::to_string(job.k);
+        break;
+      }
+    }
+    SolverResult result = solver->solve(problem, job.k, control);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    const Solution& solution = result.solution;
+    std::ostringstream line;
+    line << name << "," << path << "," << problem.size() << "," << solution.size() << "," << parameter << ","
+         << job.repetition << "," << solution.evaluate(problem) << "," << elapsed_seconds.count() << std::endl;
+    if (options_.debug) {
+      for (int j{0}; j < solution.size(); ++j) {
+        for (int k{0}; k < solution[j].size(); ++k) {
+          line << solution[j][k] << " ";
+        } line << std::endl;
+      }
+    }
+    return line.str();
+  }
+};
+
+#endif  // BATCH_RUNNER_H
@@ -0,0 +1,275 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file blocked-distance.h
+ * @brief BlockedDistances class
+ *        This class finds the nearest center of many points at once as a
+ *        blocked matrix product, ||x||² + ||c||² - 2·x·c
+ */
+
+#ifndef BLOCKED_DISTANCE_H
+#define BLOCKED_DISTANCE_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "distance.h"
+#include "instrumentation.h"
+
+namespace blocked {
+
+const int kBlockRows = 64;  // Puntos que recorren un panel mientras está en L1
+
+/**
+ * @brief Centers of a panel: 128 bytes of T, two AVX-512 registers
+ */
+template <typename T>
+inline constexpr int kLanes = 128 / sizeof(T);
+
+/**
+ * @brief GCC vector of Bytes bytes of T, the width of the registers of the
+ *        instruction set a kernel is compiled for. A wider vector would be
+ *        kept in memory
+ */
+template <typename T, int Bytes>
+struct SimdVector;
+
+template <>
+struct SimdVector<double, 16> {
+  typedef double type __attribute__((vector_size(16), aligned(sizeof(double))));
+};
+
+template <>
+struct SimdVector<double, 32> {
+  typedef double type __attribute__((vector_size(32), aligned(sizeof(double))));
+};
+
+template <>
+struct SimdVector<double, 64> {
+  typedef double type __attribute__((vector_size(64), aligned(sizeof(double))));
+};
+
+template <>
+struct SimdVector<float, 16> {
+  typedef float type __attribute__((vector_size(16), aligned(sizeof(float))));
+};
+
+template <>
+struct SimdVector<float, 32> {
+  typedef float type __attribute__((vector_size(32), aligned(sizeof(float))));
+};
+
+template <>
+struct SimdVector<float, 64> {
+  typedef float type __attribute__((vector_size(64), aligned(sizeof(float))));
+};
+
+/**
+ * @brief Nearest center of `count` consecutive points (row-major, d values
+ *        each) among the panels, updating labels and best in place. Every
+ *        panel holds kLanes<T> centers transposed (d rows of kLanes<T>
+ *        values), so the micro-kernel keeps Rows x kLanes<T> dot products in
+ *        registers and reads each coordinate of a point once per panel
+ * @tparam Bytes Width of a register of the instruction set
+ * @tparam Rows Points of the micro-kernel: as many as the accumulators
+ *              leave registers for
+ */
+template <typename T, int Bytes, int Rows>
+__attribute__((always_inline)) inline void block_argmin(const T* panels, const T* center_norms, int k, int d,
+                                                        const T* points, const T* point_norms, int count,
+                                                        int* labels, T* best) {
+  typedef typename SimdVector<T, Bytes>::type Vector;
+  const int lanes = kLanes<T>;
+  const int parts = lanes * sizeof(T) / Bytes;  // Registros por fila de panel
+  const int width = Bytes / sizeof(T);
+  int panel_count = (k + lanes - 1) / lanes;
+  for (int panel{0}; panel < panel_count; ++panel) {
+    const T* packed = panels + size_t(panel) * d * lanes;
+    const T* norms = center_norms + size_t(panel) * lanes;
+    int centers = std::min(lanes, k - panel * lanes);
+    for (int r{0}; r < count; r += Rows) {
+      int rows = std::min(Rows, count - r);
+      // Las filas que faltan repiten la última: se calculan pero no se usan
+      const T* x[Rows];
+      for (int i{0}; i < Rows; ++i) {
+        x[i] = points + size_t(r + std::min(i, rows - 1)) * d;
+      }
+      Vector acc[Rows][parts] = {};
+      for (int p{0}; p < d; ++p) {
+        const T* row = packed + size_t(p) * lanes;
+        Vector c[parts];
+#pragma GCC unroll 8
+        for (int q{0}; q < parts; ++q) {
+          c[q] = *reinterpret_cast<const Vector*>(row + q * width);
+        }
+#pragma GCC unroll 8
+        for (int i{0}; i < Rows; ++i) {
+          T a = x[i][p];
+#pragma GCC unroll 8
+          for (int q{0}; q < parts; ++q) {
+            acc[i][q] += a * c[q];
+          }
+        }
+      }
+      // Los acumuladores se guardan por valor para que sigan en registros durante el bucle
+      T dots[Rows][lanes];
+#pragma GCC unroll 8
+      for (int i{0}; i < Rows; ++i) {
+#pragma GCC unroll 8
+        for (int q{0}; q < parts; ++q) {
+          *reinterpret_cast<Vector*>(dots[i] + q * width) = acc[i][q];
+        }
+      }
+      // Argmin del bloque; los centros se recorren en orden, así que los empates van al menor índice
+      for (int i{0}; i < rows; ++i) {
+        for (int j{0}; j < centers; ++j) {
+          T distance = point_norms[r + i] + norms[j] - 2 * dots[i][j];
+          if (distance < best[r + i]) {
+            best[r + i] = distance;
+            labels[r + i] = panel * lanes + j;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+using BlockKernel = void (*)(const T*, const T*, int, int, const T*, const T*, int, int*, T*);
+
+template <typename T>
+void block_argmin_scalar(const T* panels, const T* center_norms, int k, int d, const T* points,
+                         const T* point_norms, int count, int* labels, T* best) {
+  block_argmin<T, 16, 1>(panels, center_norms, k, d, points, point_norms, count, labels, best);
+}
+
+#ifdef DISTANCE_X86
+
+template <typename T>
+__attribute__((target("avx2,fma")))
+void block_argmin_avx2(const T* panels, const T* center_norms, int k, int d, const T* points,
+                       const T* point_norms, int count, int* labels, T* best) {
+  block_argmin<T, 32, 2>(panels, center_norms, k, d, points, point_norms, count, labels, best);
+}
+
+template <typename T>
+__attribute__((target("avx512f")))
+void block_argmin_avx512(const T* panels, const T* center_norms, int k, int d, const T* points,
+                         const T* point_norms, int count, int* labels, T* best) {
+  block_argmin<T, 64, 8>(panels, center_norms, k, d, points, point_norms, count, labels, best);
+}
+
+#endif  // DISTANCE_X86
+
+/**
+ * @brief Block kernel for the instruction set of the distance kernels
+ */
+template <typename T>
+BlockKernel<T> block_kernel() {
+  static const BlockKernel<T> selected = []() -> BlockKernel<T> {
+    switch (distance_kernels<T>().isa) {
+#ifdef DISTANCE_X86
+      case Isa::kAvx512:
+        return block_argmin_avx512<T>;
+      case Isa::kAvx2:
+        return block_argmin_avx2<T>;
+#endif
+      default:
+        return block_argmin_scalar<T>;
+    }
+  }();
+  return selected;
+}
+
+}  // namespace blocked
+
+/**
+ * @brief Nearest of k centers for blocks of points, computed from the
+ *        expansion ||x||² + ||c||² - 2·x·c with a register-blocked
+ *        micro-kernel and a running argmin per point, so the n x k distance
+ *        matrix is never stored. The expansion loses about
+ *        eps·(||x||² + ||c||²) to cancellation, so labels can differ from a
+ *        direct scan on near ties. Worth it when k and d are both large
+ * @tparam T Precision of the points and centers
+*/
+template <typename T>
+class BlockedDistances {
+ public:
+  /**
+   * @brief Packs k row-major centers of d dimensions into panels
+  */
+  template <typename U>
+  void set_centers(const U* centers, int k, int d) {
+    k_ = k;
+    d_ = d;
+    int panel_count = (k + blocked::kLanes<T> - 1) / blocked::kLanes<T>;
+    panels_.assign(size_t(panel_count) * d * blocked::kLanes<T>, 0);
+    norms_.assign(size_t(panel_count) * blocked::kLanes<T>, 0);
+    for (int c{0}; c < k; ++c) {
+      T* panel = panels_.data() + size_t(c / blocked::kLanes<T>) * d * blocked::kLanes<T>;
+      int lane = c % blocked::kLanes<T>;
+      T norm{0};
+      for (int p{0}; p < d; ++p) {
+        T value = centers[size_t(c) * d + p];
+        panel[size_t(p) * blocked::kLanes<T> + lane] = value;
+        norm += value * value;
+      }
+      norms_[c] = norm;
+    }
+  }
+
+  const int size() const {
+    return k_;
+  }
+
+  /**
+   * @brief Nearest center of the points [begin, end) of a row-major array
+   * @param point_norms Squared norm of every point, or null to compute them
+   * @param labels Nearest center of each point, indexed from begin
+   * @param distances Squared distance to it (clamped at 0), indexed from begin
+  */
+  void nearest(const T* points, const T* point_norms, int begin, int end, int* labels, T* distances) const {
+    blocked::BlockKernel<T> kernel = blocked::block_kernel<T>();
+    T norms[blocked::kBlockRows];
+    for (int start{begin}; start < end; start += blocked::kBlockRows) {
+      int rows = std::min(blocked::kBlockRows, end - start);
+      const T* block = points + size_t(start) * d_;
+      const T* block_norms = point_norms ? point_norms + start : norms;
+      if (!point_norms) {
+        for (int i{0}; i < rows; ++i) {
+          norms[i] = squared_norm(block + size_t(i) * d_);
+        }
+      }
+      int* block_labels = labels + (start - begin);
+      T* best = distances + (start - begin);
+      std::fill(best, best + rows, T(INFINITY));
+      std::fill(block_labels, block_labels + rows, 0);
+      kernel(panels_.data(), norms_.data(), k_, d_, block, block_norms, rows, block_labels, best);
+      for (int i{0}; i < rows; ++i) {
+        best[i] = std::max(best[i], T(0));
+      }
+    }
+    INSTRUMENT_COUNT(kDistances, uint64_t(end - begin) * k_);
+  }
+
+  T squared_norm(const T* x) const {
+    T norm{0};
+    for (int p{0}; p < d_; ++p) {
+      norm += x[p] * x[p];
+    }
+    return norm;
+  }
+
+ private:
+  int k_{0};
+  int d_{0};
+  std::vector<T> panels_;  // Centros traspuestos, kLanes<T> por panel (el último con ceros)
+  std::vector<T> norms_;   // Norma al cuadrado de cada centro (0 en el relleno)
+};
+
+#endif  // BLOCKED_DISTANCE_H
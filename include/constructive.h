@@ -0,0 +1,115 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file constructive.h
+ * @brief GreedyConstructor class
+ *        This class implements the constructive phase shared by GRASP and GVNS
+ */
+
+#ifndef CONSTRUCTIVE_H
+#define CONSTRUCTIVE_H
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "solution.h"
+#include "distance-matrix.h"
+#include "solver-control.h"
+#include "instrumentation.h"
+
+/**
+ * @brief Greedy randomized construction of a solution with k service points.
+ *        Each step adds a random point of the restricted candidate list (LRC):
+ *        the lrc_size points farthest from the service points chosen so far.
+ *        The distance of every point to the solution is kept between steps
+ *        and only compared with the new service point, and the LRC is found
+ *        by partial selection, so a construction costs O(n·k) distances.
+ *        If the control of the solver asks to stop, the remaining service
+ *        points are drawn at random, so a stopped run still gets a solution
+*/
+class GreedyConstructor {
+ public:
+  GreedyConstructor(const Problem& problem) : GreedyConstructor(problem, PointDistances(problem)) {}
+
+  /**
+   * @param distances Distances between points of the problem
+   * @param control Limits of the solver, or null
+  */
+  GreedyConstructor(const Problem& problem, const PointDistances& distances, const SolverControl* control = nullptr)
+      : problem_(problem), distances_(distances), min_distances_(problem.size()), order_(problem.size()),
+        control_(control) {}
+
+  /**
+   * @brief Builds a solution
+   * @param k Number of service points
+   * @param lrc_size Size of the restricted candidate list
+   * @param gen Random generator of the caller
+  */
+  Solution construct(int k, int lrc_size, std::mt19937& gen) {
+    Solution solution(problem_);
+    construct(k, lrc_size, gen, solution);
+    return solution;
+  }
+
+  /**
+   * @brief Builds a solution into an existing one of the same problem,
+   *        reusing its buffers
+  */
+  void construct(int k, int lrc_size, std::mt19937& gen, Solution& solution) {
+    INSTRUMENT_SCOPE(kConstruction);
+    int n = problem_.size();
+    solution.clear();
+    std::fill(min_distances_.begin(), min_distances_.end(), INFINITY);
+    // Seleccionar un punto aleatorio como solución inicial
+    std::uniform_int_distribution<> dis(0, n - 1);
+    add(solution, dis(gen));
+    int candidates = std::max(1, std::min(lrc_size, n));
+    // Mientras no se haya alcanzado el número de puntos de servicio
+    while (solution.size() < k) {
+      if (control_ && control_->stop_requested()) {
+        // Sin tiempo para la fase voraz: el resto de puntos de servicio al azar
+        while (solution.size() < k) {
+          int j{dis(gen)};
+          if (!solution.contains(j)) solution.add(j);
+        }
+        break;
+      }
+      // Los lrc_size puntos con la distancia mínima más alta; los empates por índice
+      auto farther = [this](int a, int b) {
+        return min_distances_[a] > min_distances_[b] || (min_distances_[a] == min_distances_[b] && a < b);
+      };
+      std::iota(order_.begin(), order_.end(), 0);
+      std::nth_element(order_.begin(), order_.begin() + candidates - 1, order_.end(), farther);
+      std::sort(order_.begin(), order_.begin() + candidates, farther);
+      // Seleccionamos un punto aleatorio del LRC
+      std::uniform_int_distribution<> lrc(0, candidates - 1);
+      add(solution, order_[lrc(gen)]);
+    }
+  }
+
+ private:
+  const Problem& problem_;
+  PointDistances distances_;
+  std::vector<double> min_distances_;  // Distancia de cada punto a la solución
+  std::vector<int> order_;
+  const SolverControl* control_;
+
+  /**
+   * @brief Adds point j to the solution and updates the distances to it
+  */
+  void add(Solution& solution, int j) {
+    solution.add(j);
+    for (int i{0}; i < problem_.size(); ++i) {
+      min_distances_[i] = std::min(min_distances_[i], distances_(i, j));
+    }
+  }
+};
+
+#endif  // CONSTRUCTIVE_H
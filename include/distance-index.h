@@ -0,0 +1,261 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file distance-index.h
+ * @brief DistanceIndex class
+ *        This class caches the nearest and second nearest service point of
+ *        every point of the problem
+ */
+
+#ifndef DISTANCE_INDEX_H
+#define DISTANCE_INDEX_H
+
+#include <vector>
+#include <cmath>
+#include "problem.h"
+#include "nearest-index.h"
+
+/**
+ * @brief Nearest and second nearest service point of every point. The
+ *        service points (Centers) are anything with size() and an
+ *        operator[] that returns a point, usually a Solution.
+ *        Removing or replacing a service point only touches the points that
+ *        had it as nearest or second nearest. When the new second nearest of
+ *        a point can not be known without comparing it with every service
+ *        point, the entry is marked stale and repaired lazily, the next time
+ *        the second nearest is needed. Rebuilding it for another solution
+ *        reuses its buffers, so one index can serve a whole search
+*/
+class DistanceIndex {
+ public:
+  struct Entry {
+    double distance{INFINITY};         // Distancia al punto de servicio más cercano
+    int center{-1};                    // Posición en la solución del más cercano
+    double second_distance{INFINITY};  // Distancia al segundo más cercano
+    int second_center{-1};             // Posición del segundo más cercano (-1 si no hay)
+    bool stale{false};                 // El segundo más cercano está por recalcular
+  };
+
+  DistanceIndex() {}
+
+  const int size() const {
+    return entries_.size();
+  }
+
+  const Entry& operator[](int i) const {
+    return entries_[i];
+  }
+
+  /**
+   * @brief Computes every entry from scratch
+  */
+  template <typename Centers>
+  void build(const Problem& problem, const Centers& centers) {
+    entries_.assign(problem.size(), Entry());
+    stale_ = problem.size();
+    for (Entry& entry: entries_) {
+      entry.stale = true;
+    }
+    repair(problem, centers);
+  }
+
+  /**
+   * @brief Sum of the distances of every point to its nearest service point
+  */
+  double sum() const {
+    double sum_of_distances{0};
+    for (const Entry& entry: entries_) {
+      sum_of_distances += entry.distance;
+    }
+    return sum_of_distances;
+  }
+
+  /**
+   * @brief Recomputes the stale entries, so every second nearest is valid
+  */
+  template <typename Centers>
+  void repair(const Problem& problem, const Centers& centers) {
+    if (stale_ == 0) return;
+    // Con muchas entradas por recalcular compensa indexar los puntos de servicio
+    bool indexed = stale_ >= kIndexedRepair;
+    if (indexed) {
+      NearestIndexKind kind = resolve_nearest_index(NearestIndexKind::kAuto, centers.size(), problem.dimensions());
+      if (!index_ || kind != index_kind_) {
+        index_ = make_nearest_index(kind, centers.size(), problem.dimensions());
+        index_kind_ = kind;
+      }
+      index_->build(centers, problem.dimensions());
+    }
+    for (int i{0}; i < size(); ++i) {
+      if (!entries_[i].stale) continue;
+      if (indexed) {
+        Neighbors neighbors = index_->nearest(problem[i].data());
+        entries_[i] = {std::sqrt(neighbors.first_distance), neighbors.first,
+                       std::sqrt(neighbors.second_distance), neighbors.second, false};
+      } else {
+        locate(problem, centers, i);
+      }
+    }
+    stale_ = 0;
+  }
+
+  /**
+   * @brief Increase of the sum of distances caused by removing each service
+   *        point: every point of a removed one moves to its second nearest.
+   *        One pass over the points prices every elimination
+   * @param losses Loss of each service point, resized to centers.size()
+  */
+  template <typename Centers>
+  void removal_losses(const Problem& problem, const Centers& centers, std::vector<double>& losses) {
+    repair(problem, centers);
+    losses.assign(centers.size(), 0);
+    for (const Entry& entry: entries_) {
+      losses[entry.center] += entry.second_distance - entry.distance;
+    }
+  }
+
+  /**
+   * @brief Updates the entries after the service point at position r was
+   *        erased from centers (the positions after it moved back by one)
+  */
+  template <typename Centers>
+  void remove_center(const Problem& problem, const Centers& centers, int r) {
+    for (int i{0}; i < size(); ++i) {
+      Entry& entry = entries_[i];
+      if (entry.center == r) {
+        if (entry.stale) {
+          locate(problem, centers, i);
+          --stale_;
+          continue;
+        }
+        entry.distance = entry.second_distance;
+        entry.center = entry.second_center;
+        mark_stale(entry);
+      } else if (entry.second_center == r) {
+        mark_stale(entry);
+      }
+      if (entry.center > r) --entry.center;
+      if (entry.second_center > r) --entry.second_center;
+    }
+  }
+
+  /**
+   * @brief Updates the entries after a service point was appended at
+   *        position `index` of the solution
+  */
+  void add_center(const Problem& problem, ConstPointSpan center, int index) {
+    for (int i{0}; i < size(); ++i) {
+      Entry& entry = entries_[i];
+      double distance{euclidean_distance(problem[i], center)};
+      if (distance < entry.distance) {
+        promote(entry, distance, index);
+      } else if (!entry.stale && distance < entry.second_distance) {
+        entry.second_distance = distance;
+        entry.second_center = index;
+      }
+    }
+  }
+
+  /**
+   * @brief Updates the entries after the service point at position r was
+   *        replaced (centers already holds the new one)
+  */
+  template <typename Centers>
+  void replace_center(const Problem& problem, const Centers& centers, int r) {
+    for (int i{0}; i < size(); ++i) {
+      Entry& entry = entries_[i];
+      if (entry.center != r && entry.second_center != r) {
+        double distance{euclidean_distance(problem[i], centers[r])};
+        if (distance < entry.distance) {
+          promote(entry, distance, r);
+        } else if (!entry.stale && distance < entry.second_distance) {
+          entry.second_distance = distance;
+          entry.second_center = r;
+        }
+      } else if (entry.stale) {
+        locate(problem, centers, i);
+        --stale_;
+      } else {
+        // El resto de puntos de servicio están a second_distance o más
+        double distance{euclidean_distance(problem[i], centers[r])};
+        if (entry.center == r) {
+          if (distance <= entry.second_distance) {
+            entry.distance = distance;
+          } else {
+            entry.distance = entry.second_distance;
+            entry.center = entry.second_center;
+            mark_stale(entry);
+          }
+        } else if (distance < entry.distance) {
+          promote(entry, distance, r);
+        } else if (distance <= entry.second_distance) {
+          entry.second_distance = distance;
+        } else {
+          mark_stale(entry);
+        }
+      }
+    }
+  }
+
+ private:
+  static const int kIndexedRepair = 64;  // Entradas a partir de las que se usa un NearestIndex
+
+  std::vector<Entry> entries_;
+  int stale_{0};  // Entradas marcadas para recalcular
+  std::unique_ptr<NearestIndex> index_;  // Índice de las reparaciones, reutilizado entre ellas
+  NearestIndexKind index_kind_{NearestIndexKind::kAuto};
+
+  /**
+   * @brief Makes a closer service point the nearest one. The old nearest
+   *        becomes the second, which is exact even for a stale entry
+  */
+  void promote(Entry& entry, double distance, int index) {
+    entry.second_distance = entry.distance;
+    entry.second_center = entry.center;
+    entry.distance = distance;
+    entry.center = index;
+    if (entry.stale) {
+      entry.stale = false;
+      --stale_;
+    }
+  }
+
+  void mark_stale(Entry& entry) {
+    entry.second_distance = INFINITY;
+    entry.second_center = -1;
+    if (!entry.stale) {
+      entry.stale = true;
+      ++stale_;
+    }
+  }
+
+  /**
+   * @brief Computes the nearest and second nearest service points of point i
+  */
+  template <typename Centers>
+  void locate(const Problem& problem, const Centers& centers, int i) {
+    Entry entry;
+    for (int j{0}; j < centers.size(); ++j) {
+      double distance{squared_euclidean_distance(problem[i], centers[j])};
+      if (distance < entry.distance) {
+        entry.second_distance = entry.distance;
+        entry.second_center = entry.center;
+        entry.distance = distance;
+        entry.center = j;
+      } else if (distance < entry.second_distance) {
+        entry.second_distance = distance;
+        entry.second_center = j;
+      }
+    }
+    entry.distance = std::sqrt(entry.distance);
+    entry.second_distance = std::sqrt(entry.second_distance);
+    entries_[i] = entry;
+  }
+};
+
+#endif  // DISTANCE_INDEX_H
@@ -0,0 +1,268 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file distance-matrix.h
+ * @brief Distances between the points of a problem
+ *        This file contains the precomputed distance matrix, the tile cache
+ *        for problems too large for it and the PointDistances accessor that
+ *        the p-median searches use
+ */
+
+#ifndef DISTANCE_MATRIX_H
+#define DISTANCE_MATRIX_H
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include "problem.h"
+#include "thread-pool.h"
+#include "solver-control.h"
+#include "instrumentation.h"
+
+/**
+ * @brief Where the p-median searches take the point to point distances from
+ *        kAuto: kMatrix if it fits in the memory budget, kDirect otherwise
+ *        kDirect: computed every time, in double precision
+ *        kMatrix: DistanceMatrix, computed once and shared by all threads
+ *        kTiles: DistanceTileCache, one per thread. A full swap sweep touches
+ *                every tile, so it only pays off when the cache holds most of
+ *                the matrix or when a distance is expensive (many dimensions)
+*/
+enum class DistanceBackend { kAuto, kDirect, kMatrix, kTiles };
+
+class DistanceMatrix;
+
+/**
+ * @brief Options of the distance backend
+*/
+struct DistanceOptions {
+  DistanceBackend backend{DistanceBackend::kAuto};
+  size_t matrix_budget{size_t(1) << 30};  // Bytes máximos de la matriz
+  size_t cache_budget{size_t(64) << 20};  // Bytes máximos de la caché de cada hilo
+  // Matriz ya calculada del mismo problema: se usa en lugar de backend
+  std::shared_ptr<const DistanceMatrix> matrix;
+};
+
+/**
+ * @brief Distances between every pair of points, in float and packed as the
+ *        strict lower triangle: n·(n-1)/2 values
+*/
+class DistanceMatrix {
+ public:
+  /**
+   * @brief Bytes needed for a problem of n points
+  */
+  static size_t bytes(int n) {
+    return size_t(n) * (n - 1) / 2 * sizeof(float);
+  }
+
+  /**
+   * @brief Computes the matrix, a chunk of rows per task of the pool
+   * @param control Limits of the solver, or null. When it asks to stop, the
+   *                remaining rows are skipped and complete() is false
+  */
+  DistanceMatrix(const Problem& problem, ThreadPool& pool, const SolverControl* control = nullptr)
+      : size_(problem.size()), values_(new float[size_t(problem.size()) * (problem.size() - 1) / 2]) {
+    int chunks = std::min(size_, pool.size() * 16);
+    std::atomic<bool> stopped{false};
+    pool.parallel_for(chunks, [&](int chunk) {
+      // Filas intercaladas: las últimas son más largas que las primeras
+      for (int i{chunk}; i < size_; i += chunks) {
+        if (control && control->stop_requested()) {
+          stopped.store(true);
+          return;
+        }
+        float* row = values_.get() + offset(i);
+        for (int j{0}; j < i; ++j) {
+          row[j] = euclidean_distance(problem[i], problem[j]);
+        }
+      }
+    });
+    complete_ = !stopped.load();
+  }
+
+  const int size() const {
+    return size_;
+  }
+
+  /**
+   * @brief Whether every row was computed
+  */
+  const bool complete() const {
+    return complete_;
+  }
+
+  float operator()(int i, int j) const {
+    if (i == j) return 0;
+    return i > j ? values_[offset(i) + j] : values_[offset(j) + i];
+  }
+
+ private:
+  int size_;
+  std::unique_ptr<float[]> values_;  // Sin inicializar: cada fila se escribe una vez
+  bool complete_{true};
+
+  static size_t offset(int i) {
+    return size_t(i) * (i - 1) / 2;
+  }
+};
+
+/**
+ * @brief Least recently used cache of square tiles of the distance matrix,
+ *        computed when first needed. Not thread-safe: one per thread
+*/
+class DistanceTileCache {
+ public:
+  /**
+   * @param budget Bytes of tiles kept at most (at least one tile)
+  */
+  DistanceTileCache(const Problem& problem, size_t budget)
+      : problem_(problem), tiles_((problem.size() + kTile - 1) / kTile),
+        capacity_(std::max<size_t>(1, budget / (sizeof(float) * kTile * kTile))) {}
+
+  float operator()(int i, int j) {
+    if (i == j) return 0;
+    if (i < j) std::swap(i, j);
+    long key = long(i / kTile) * tiles_ + j / kTile;
+    if (key != last_key_) {
+      last_ = &tile(key, i / kTile, j / kTile);
+      last_key_ = key;
+    }
+    return (*last_)[(i % kTile) * kTile + j % kTile];
+  }
+
+ private:
+  static const int kTile = 128;  // 64 KiB por bloque
+
+  const Problem& problem_;
+  long tiles_;
+  size_t capacity_;
+  std::list<std::pair<long, std::vector<float>>> recent_;  // El más reciente al principio
+  std::unordered_map<long, std::list<std::pair<long, std::vector<float>>>::iterator> lookup_;
+  long last_key_{-1};
+  const std::vector<float>* last_{nullptr};
+
+  const std::vector<float>& tile(long key, int row_block, int column_block) {
+    auto found = lookup_.find(key);
+    if (found != lookup_.end()) {
+      recent_.splice(recent_.begin(), recent_, found->second);
+      return found->second->second;
+    }
+    std::vector<float> values;
+    if (lookup_.size() >= capacity_) {  // Se reutiliza el bloque menos usado
+      values = std::move(recent_.back().second);
+      lookup_.erase(recent_.back().first);
+      recent_.pop_back();
+    }
+    values.assign(kTile * kTile, 0);
+    int row_end = std::min(problem_.size(), (row_block + 1) * kTile);
+    int column_end = std::min(problem_.size(), (column_block + 1) * kTile);
+    for (int i{row_block * kTile}; i < row_end; ++i) {
+      for (int j{column_block * kTile}; j < column_end; ++j) {
+        values[(i % kTile) * kTile + j % kTile] = euclidean_distance(problem_[i], problem_[j]);
+      }
+    }
+    recent_.emplace_front(key, std::move(values));
+    lookup_[key] = recent_.begin();
+    return recent_.front().second;
+  }
+};
+
+/**
+ * @brief Distance between two points of the problem, from the backend that
+ *        was chosen for it. Float backends are exact to about 1e-7, so
+ *        searches must ignore improvements below tolerance()
+*/
+class PointDistances {
+ public:
+  /**
+   * @brief Direct computation in double precision
+  */
+  PointDistances(const Problem& problem) : problem_(problem) {}
+
+  PointDistances(const Problem& problem, const DistanceMatrix* matrix, DistanceTileCache* cache)
+      : problem_(problem), matrix_(matrix), cache_(cache) {}
+
+  double operator()(int i, int j) const {
+    INSTRUMENT_COUNT(kLookups, 1);
+    if (matrix_) return (*matrix_)(i, j);
+    if (cache_) return (*cache_)(i, j);
+    return euclidean_distance(problem_[i], problem_[j]);
+  }
+
+  /**
+   * @brief Relative change of an objective that is not just rounding error
+  */
+  const double tolerance() const {
+    return matrix_ || cache_ ? 1e-5 : 1e-12;
+  }
+
+ private:
+  const Problem& problem_;
+  const DistanceMatrix* matrix_{nullptr};
+  DistanceTileCache* cache_{nullptr};
+};
+
+/**
+ * @brief Distance backend of one search, shared by its threads: the matrix
+ *        is built once, or taken from the options if the caller shares one
+ *        between searches, and the tile caches are created per thread
+*/
+class DistanceBackendSet {
+ public:
+  /**
+   * @param control Limits of the solver, or null. The matrix takes O(n²)
+   *                before the search starts; if the control stops its
+   *                construction, the search computes the distances directly
+  */
+  DistanceBackendSet(const Problem& problem, const DistanceOptions& options, ThreadPool& pool,
+                     const SolverControl* control = nullptr)
+      : problem_(problem), options_(options) {
+    if (options.matrix) {
+      if (options.matrix->size() != problem.size()) {
+        throw std::invalid_argument("The distance matrix belongs to another problem");
+      }
+      matrix_ = options.matrix;
+      return;
+    }
+    DistanceBackend backend = options.backend;
+    if (backend == DistanceBackend::kAuto) {
+      backend = DistanceMatrix::bytes(problem.size()) <= options.matrix_budget ? DistanceBackend::kMatrix
+                                                                               : DistanceBackend::kDirect;
+    }
+    if (backend == DistanceBackend::kMatrix && problem.size() > 1) {
+      matrix_ = std::make_shared<const DistanceMatrix>(problem, pool, control);
+      if (!matrix_->complete()) matrix_.reset();
+    }
+    tiles_ = backend == DistanceBackend::kTiles;
+  }
+
+  /**
+   * @brief Tile cache for one thread, or null if the backend has none
+  */
+  std::unique_ptr<DistanceTileCache> make_cache() const {
+    if (!tiles_) return nullptr;
+    return std::make_unique<DistanceTileCache>(problem_, options_.cache_budget);
+  }
+
+  PointDistances distances(DistanceTileCache* cache) const {
+    return PointDistances(problem_, matrix_.get(), cache);
+  }
+
+ private:
+  const Problem& problem_;
+  DistanceOptions options_;
+  std::shared_ptr<const DistanceMatrix> matrix_;
+  bool tiles_{false};
+};
+
+#endif  // DISTANCE_MATRIX_H
@@ -0,0 +1,474 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file distance.h
+ * @brief Distance kernels
+ *        This file contains the vectorized distance kernels (SSE2, AVX2 and
+ *        AVX-512) and the runtime selection of the best one for the CPU
+ */
+
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include "instrumentation.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DISTANCE_X86 1
+#endif
+
+/**
+ * @brief Instruction sets with a distance kernel, from slowest to fastest
+*/
+enum class Isa { kScalar, kSse2, kAvx2, kAvx512 };
+
+inline const char* isa_name(Isa isa) {
+  switch (isa) {
+    case Isa::kSse2: return "sse2";
+    case Isa::kAvx2: return "avx2";
+    case Isa::kAvx512: return "avx512";
+    default: return "scalar";
+  }
+}
+
+/**
+ * @brief Kernels for one scalar type
+ *        squared_l2(a, b, d): squared euclidean distance between a and b
+ *        batch_squared_l2(x, centroids, k, d, out): out[j] = squared_l2(x, centroids + j * d)
+*/
+template <typename T>
+struct DistanceKernels {
+  Isa isa;
+  T (*squared_l2)(const T* a, const T* b, int d);
+  void (*batch_squared_l2)(const T* x, const T* centroids, int k, int d, T* out);
+};
+
+namespace kernels {
+
+template <typename T>
+inline T squared_l2_scalar(const T* a, const T* b, int d) {
+  T distance{0};
+  for (int i{0}; i < d; ++i) {
+    T difference = a[i] - b[i];
+    distance += difference * difference;
+  }
+  return distance;
+}
+
+/**
+ * @brief One point against k row-major centroids, one call of a single-pair
+ *        kernel per centroid. The scalar and SSE2 levels use it; AVX2 and
+ *        AVX-512 have real batched kernels
+*/
+template <typename T, T (*Kernel)(const T*, const T*, int)>
+inline void pairwise_batch_squared_l2(const T* x, const T* centroids, int k, int d, T* out) {
+  for (int j{0}; j < k; ++j) {
+    out[j] = Kernel(x, centroids + size_t(j) * d, d);
+  }
+}
+
+/**
+ * @brief Adds the dimensions [i, d) that the vector loop left over
+*/
+template <typename T>
+inline T add_tail(const T* a, const T* b, int i, int d, T distance) {
+  for (; i < d; ++i) {
+    T difference = a[i] - b[i];
+    distance += difference * difference;
+  }
+  return distance;
+}
+
+// Centroides por pasada de los núcleos por lotes: cada carga de x sirve para todos ellos
+const int kBatchCentroids{4};
+
+#ifdef DISTANCE_X86
+
+__attribute__((target("sse2")))
+inline double squared_l2_sse2(const double* a, const double* b, int d) {
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  int i{0};
+  for (; i + 4 <= d; i += 4) {
+    __m128d d0 = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+    __m128d d1 = _mm_sub_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2));
+    sum0 = _mm_add_pd(sum0, _mm_mul_pd(d0, d0));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(d1, d1));
+  }
+  sum0 = _mm_add_pd(sum0, sum1);
+  double lanes[2];
+  _mm_storeu_pd(lanes, sum0);
+  double distance = lanes[0] + lanes[1];
+  for (; i < d; ++i) {
+    double difference = a[i] - b[i];
+    distance += difference * difference;
+  }
+  return distance;
+}
+
+__attribute__((target("sse2")))
+inline float squared_l2_sse2(const float* a, const float* b, int d) {
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  int i{0};
+  for (; i + 8 <= d; i += 8) {
+    __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(d0, d0));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(d1, d1));
+  }
+  sum0 = _mm_add_ps(sum0, sum1);
+  float lanes[4];
+  _mm_storeu_ps(lanes, sum0);
+  float distance = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < d; ++i) {
+    float difference = a[i] - b[i];
+    distance += difference * difference;
+  }
+  return distance;
+}
+
+__attribute__((target("avx2,fma")))
+inline double reduce_avx2(__m256d sum0, __m256d sum1) {
+  sum0 = _mm256_add_pd(sum0, sum1);
+  __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum0), _mm256_extractf128_pd(sum0, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+__attribute__((target("avx2,fma")))
+inline float reduce_avx2(__m256 sum0, __m256 sum1) {
+  sum0 = _mm256_add_ps(sum0, sum1);
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum0), _mm256_extractf128_ps(sum0, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+  return _mm_cvtss_f32(half);
+}
+
+__attribute__((target("avx2,fma")))
+inline double squared_l2_avx2(const double* a, const double* b, int d) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  int i{0};
+  for (; i + 8 <= d; i += 8) {
+    __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+    __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+    sum0 = _mm256_fmadd_pd(d0, d0, sum0);
+    sum1 = _mm256_fmadd_pd(d1, d1, sum1);
+  }
+  for (; i + 4 <= d; i += 4) {
+    __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+    sum0 = _mm256_fmadd_pd(d0, d0, sum0);
+  }
+  return add_tail(a, b, i, d, reduce_avx2(sum0, sum1));
+}
+
+__attribute__((target("avx2,fma")))
+inline float squared_l2_avx2(const float* a, const float* b, int d) {
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  int i{0};
+  for (; i + 16 <= d; i += 16) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    sum0 = _mm256_fmadd_ps(d0, d0, sum0);
+    sum1 = _mm256_fmadd_ps(d1, d1, sum1);
+  }
+  for (; i + 8 <= d; i += 8) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    sum0 = _mm256_fmadd_ps(d0, d0, sum0);
+  }
+  return add_tail(a, b, i, d, reduce_avx2(sum0, sum1));
+}
+
+/**
+ * @brief kBatchCentroids centroids per pass, each with the accumulators and
+ *        the reduction of squared_l2_avx2, so every result is bit for bit
+ *        the one of the single-pair kernel; x is loaded once per pass
+*/
+__attribute__((target("avx2,fma")))
+inline void batch_squared_l2_avx2(const double* x, const double* centroids, int k, int d, double* out) {
+  int j{0};
+  for (; j + kBatchCentroids <= k; j += kBatchCentroids) {
+    const double* c = centroids + size_t(j) * d;
+    __m256d sum0[kBatchCentroids];
+    __m256d sum1[kBatchCentroids];
+#pragma GCC unroll 4
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      sum0[b] = _mm256_setzero_pd();
+      sum1[b] = _mm256_setzero_pd();
+    }
+    int i{0};
+    for (; i + 8 <= d; i += 8) {
+      __m256d x0 = _mm256_loadu_pd(x + i);
+      __m256d x1 = _mm256_loadu_pd(x + i + 4);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m256d d0 = _mm256_sub_pd(x0, _mm256_loadu_pd(c + size_t(b) * d + i));
+        __m256d d1 = _mm256_sub_pd(x1, _mm256_loadu_pd(c + size_t(b) * d + i + 4));
+        sum0[b] = _mm256_fmadd_pd(d0, d0, sum0[b]);
+        sum1[b] = _mm256_fmadd_pd(d1, d1, sum1[b]);
+      }
+    }
+    for (; i + 4 <= d; i += 4) {
+      __m256d x0 = _mm256_loadu_pd(x + i);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m256d d0 = _mm256_sub_pd(x0, _mm256_loadu_pd(c + size_t(b) * d + i));
+        sum0[b] = _mm256_fmadd_pd(d0, d0, sum0[b]);
+      }
+    }
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      out[j + b] = add_tail(x, c + size_t(b) * d, i, d, reduce_avx2(sum0[b], sum1[b]));
+    }
+  }
+  for (; j < k; ++j) {
+    out[j] = squared_l2_avx2(x, centroids + size_t(j) * d, d);
+  }
+}
+
+__attribute__((target("avx2,fma")))
+inline void batch_squared_l2_avx2(const float* x, const float* centroids, int k, int d, float* out) {
+  int j{0};
+  for (; j + kBatchCentroids <= k; j += kBatchCentroids) {
+    const float* c = centroids + size_t(j) * d;
+    __m256 sum0[kBatchCentroids];
+    __m256 sum1[kBatchCentroids];
+#pragma GCC unroll 4
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      sum0[b] = _mm256_setzero_ps();
+      sum1[b] = _mm256_setzero_ps();
+    }
+    int i{0};
+    for (; i + 16 <= d; i += 16) {
+      __m256 x0 = _mm256_loadu_ps(x + i);
+      __m256 x1 = _mm256_loadu_ps(x + i + 8);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m256 d0 = _mm256_sub_ps(x0, _mm256_loadu_ps(c + size_t(b) * d + i));
+        __m256 d1 = _mm256_sub_ps(x1, _mm256_loadu_ps(c + size_t(b) * d + i + 8));
+        sum0[b] = _mm256_fmadd_ps(d0, d0, sum0[b]);
+        sum1[b] = _mm256_fmadd_ps(d1, d1, sum1[b]);
+      }
+    }
+    for (; i + 8 <= d; i += 8) {
+      __m256 x0 = _mm256_loadu_ps(x + i);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m256 d0 = _mm256_sub_ps(x0, _mm256_loadu_ps(c + size_t(b) * d + i));
+        sum0[b] = _mm256_fmadd_ps(d0, d0, sum0[b]);
+      }
+    }
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      out[j + b] = add_tail(x, c + size_t(b) * d, i, d, reduce_avx2(sum0[b], sum1[b]));
+    }
+  }
+  for (; j < k; ++j) {
+    out[j] = squared_l2_avx2(x, centroids + size_t(j) * d, d);
+  }
+}
+
+__attribute__((target("avx512f")))
+inline double squared_l2_avx512(const double* a, const double* b, int d) {
+  __m512d sum = _mm512_setzero_pd();
+  int i{0};
+  for (; i + 8 <= d; i += 8) {
+    __m512d difference = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+    sum = _mm512_fmadd_pd(difference, difference, sum);
+  }
+  if (i < d) {  // Resto con carga enmascarada
+    __mmask8 mask = static_cast<__mmask8>((1u << (d - i)) - 1);
+    __m512d difference = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i));
+    sum = _mm512_fmadd_pd(difference, difference, sum);
+  }
+  return _mm512_reduce_add_pd(sum);
+}
+
+__attribute__((target("avx512f")))
+inline float squared_l2_avx512(const float* a, const float* b, int d) {
+  __m512 sum = _mm512_setzero_ps();
+  int i{0};
+  for (; i + 16 <= d; i += 16) {
+    __m512 difference = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    sum = _mm512_fmadd_ps(difference, difference, sum);
+  }
+  if (i < d) {
+    __mmask16 mask = static_cast<__mmask16>((1u << (d - i)) - 1);
+    __m512 difference = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+    sum = _mm512_fmadd_ps(difference, difference, sum);
+  }
+  return _mm512_reduce_add_ps(sum);
+}
+
+/**
+ * @brief kBatchCentroids centroids per pass, bit for bit like
+ *        squared_l2_avx512; x is loaded once per pass
+*/
+__attribute__((target("avx512f")))
+inline void batch_squared_l2_avx512(const double* x, const double* centroids, int k, int d, double* out) {
+  int j{0};
+  for (; j + kBatchCentroids <= k; j += kBatchCentroids) {
+    const double* c = centroids + size_t(j) * d;
+    __m512d sum[kBatchCentroids];
+#pragma GCC unroll 4
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      sum[b] = _mm512_setzero_pd();
+    }
+    int i{0};
+    for (; i + 8 <= d; i += 8) {
+      __m512d point = _mm512_loadu_pd(x + i);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m512d difference = _mm512_sub_pd(point, _mm512_loadu_pd(c + size_t(b) * d + i));
+        sum[b] = _mm512_fmadd_pd(difference, difference, sum[b]);
+      }
+    }
+    if (i < d) {
+      __mmask8 mask = static_cast<__mmask8>((1u << (d - i)) - 1);
+      __m512d point = _mm512_maskz_loadu_pd(mask, x + i);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m512d difference = _mm512_sub_pd(point, _mm512_maskz_loadu_pd(mask, c + size_t(b) * d + i));
+        sum[b] = _mm512_fmadd_pd(difference, difference, sum[b]);
+      }
+    }
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      out[j + b] = _mm512_reduce_add_pd(sum[b]);
+    }
+  }
+  for (; j < k; ++j) {
+    out[j] = squared_l2_avx512(x, centroids + size_t(j) * d, d);
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void batch_squared_l2_avx512(const float* x, const float* centroids, int k, int d, float* out) {
+  int j{0};
+  for (; j + kBatchCentroids <= k; j += kBatchCentroids) {
+    const float* c = centroids + size_t(j) * d;
+    __m512 sum[kBatchCentroids];
+#pragma GCC unroll 4
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      sum[b] = _mm512_setzero_ps();
+    }
+    int i{0};
+    for (; i + 16 <= d; i += 16) {
+      __m512 point = _mm512_loadu_ps(x + i);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m512 difference = _mm512_sub_ps(point, _mm512_loadu_ps(c + size_t(b) * d + i));
+        sum[b] = _mm512_fmadd_ps(difference, difference, sum[b]);
+      }
+    }
+    if (i < d) {
+      __mmask16 mask = static_cast<__mmask16>((1u << (d - i)) - 1);
+      __m512 point = _mm512_maskz_loadu_ps(mask, x + i);
+#pragma GCC unroll 4
+      for (int b{0}; b < kBatchCentroids; ++b) {
+        __m512 difference = _mm512_sub_ps(point, _mm512_maskz_loadu_ps(mask, c + size_t(b) * d + i));
+        sum[b] = _mm512_fmadd_ps(difference, difference, sum[b]);
+      }
+    }
+    for (int b{0}; b < kBatchCentroids; ++b) {
+      out[j + b] = _mm512_reduce_add_ps(sum[b]);
+    }
+  }
+  for (; j < k; ++j) {
+    out[j] = squared_l2_avx512(x, centroids + size_t(j) * d, d);
+  }
+}
+
+#endif  // DISTANCE_X86
+
+/**
+ * @brief Best instruction set supported by the CPU. The environment variable
+ *        KMEANS_ISA (scalar, sse2, avx2, avx512) lowers the choice
+*/
+inline Isa detect_isa() {
+  Isa isa{Isa::kScalar};
+#ifdef DISTANCE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) isa = Isa::kSse2;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) isa = Isa::kAvx2;
+  if (__builtin_cpu_supports("avx512f")) isa = Isa::kAvx512;
+#endif
+  const char* requested = std::getenv("KMEANS_ISA");
+  if (requested != nullptr) {
+    for (Isa candidate: {Isa::kScalar, Isa::kSse2, Isa::kAvx2, Isa::kAvx512}) {
+      if (std::strcmp(requested, isa_name(candidate)) == 0 && candidate < isa) {
+        isa = candidate;
+      }
+    }
+  }
+  return isa;
+}
+
+template <typename T>
+DistanceKernels<T> make_kernels(Isa isa) {
+  switch (isa) {
+#ifdef DISTANCE_X86
+    case Isa::kAvx512:
+      return {isa, squared_l2_avx512, batch_squared_l2_avx512};
+    case Isa::kAvx2:
+      return {isa, squared_l2_avx2, batch_squared_l2_avx2};
+    case Isa::kSse2:
+      return {isa, squared_l2_sse2, pairwise_batch_squared_l2<T, squared_l2_sse2>};
+#endif
+    default:
+      return {Isa::kScalar, squared_l2_scalar<T>, pairwise_batch_squared_l2<T, squared_l2_scalar<T>>};
+  }
+}
+
+}  // namespace kernels
+
+/**
+ * @brief Kernels selected for this CPU, resolved once on first use
+*/
+template <typename T>
+const DistanceKernels<T>& distance_kernels() {
+  static const DistanceKernels<T> selected = kernels::make_kernels<T>(kernels::detect_isa());
+  return selected;
+}
+
+template <typename T>
+T squared_l2(const T* a, const T* b, int d) {
+  INSTRUMENT_COUNT(kDistances, 1);
+  return distance_kernels<T>().squared_l2(a, b, d);
+}
+
+template <typename T>
+T l2(const T* a, const T* b, int d) {
+  INSTRUMENT_COUNT(kDistances, 1);
+  return std::sqrt(distance_kernels<T>().squared_l2(a, b, d));
+}
+
+/**
+ * @brief Squared distances from x to k row-major centroids
+*/
+template <typename T>
+void batch_squared_l2(const T* x, const T* centroids, int k, int d, T* out) {
+  INSTRUMENT_COUNT(kDistances, k);
+  distance_kernels<T>().batch_squared_l2(x, centroids, k, d, out);
+}
+
+/**
+ * @brief Distances from x to k row-major centroids
+*/
+template <typename T>
+void batch_l2(const T* x, const T* centroids, int k, int d, T* out) {
+  INSTRUMENT_COUNT(kDistances, k);
+  distance_kernels<T>().batch_squared_l2(x, centroids, k, d, out);
+  for (int j{0}; j < k; ++j) {
+    out[j] = std::sqrt(out[j]);
+  }
+}
+
+#endif  // DISTANCE_H
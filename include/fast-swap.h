@@ -0,0 +1,239 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file fast-swap.h
+ * @brief SwapEngine and CandidateLists classes
+ *        This file evaluates the swap neighbourhood of a p-median solution
+ *        without copying it (fast swap of Whitaker, Resende and Werneck),
+ *        optionally restricted to the points near the service points
+ */
+
+#ifndef FAST_SWAP_H
+#define FAST_SWAP_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include "problem.h"
+#include "distance-index.h"
+#include "distance-matrix.h"
+#include "thread-pool.h"
+#include "solver-control.h"
+#include "instrumentation.h"
+
+/**
+ * @brief The m nearest points of every point of a problem. A swap restricted
+ *        to them only brings in points near some service point: far
+ *        candidates rarely improve, and skipping them makes the swap
+ *        neighbourhood O(k·m) candidates instead of O(n)
+*/
+class CandidateLists {
+ public:
+  /**
+   * @brief Finds the lists, splitting the points among the threads of a pool
+   * @param size Points per list (m), at most the other n - 1 points
+   * @param control Limits of the solver, or null. When it asks to stop, the
+   *                remaining lists are left with point 0: still valid
+   *                indices for a search that is stopping as well
+  */
+  CandidateLists(const Problem& problem, int size, ThreadPool& pool, const SolverControl* control = nullptr)
+      : size_(std::max(0, std::min(size, problem.size() - 1))), neighbors_(size_t(problem.size()) * size_) {
+    int n = problem.size();
+    int chunks = std::max(1, std::min(n, pool.size()));
+    pool.parallel_for(chunks, [&](int chunk) {
+      std::pair<int, int> range = chunk_range(n, chunks, chunk);
+      std::vector<double> distances(n);
+      std::vector<int> order(n);
+      for (int i{range.first}; i < range.second; ++i) {
+        if (control && control->stop_requested()) return;
+        batch_squared_l2(problem[i].data(), problem.data(), n, problem.dimensions(), distances.data());
+        distances[i] = INFINITY;  // El propio punto no es candidato
+        // Los más cercanos primero; los empates por índice
+        auto closer = [&distances](int a, int b) {
+          return distances[a] < distances[b] || (distances[a] == distances[b] && a < b);
+        };
+        std::iota(order.begin(), order.end(), 0);
+        std::nth_element(order.begin(), order.begin() + size_, order.end(), closer);
+        std::sort(order.begin(), order.begin() + size_, closer);
+        std::copy(order.begin(), order.begin() + size_, neighbors_.begin() + size_t(i) * size_);
+      }
+    });
+  }
+
+  const int size() const {
+    return size_;
+  }
+
+  /**
+   * @brief Nearest points of the point i, closest first
+  */
+  const int* operator[](int i) const {
+    return neighbors_.data() + size_t(i) * size_;
+  }
+
+  /**
+   * @brief Points that are not service points and are in the list of some
+   *        service point, in increasing order
+   * @param candidates Output
+   * @param marks Scratch buffer, one per point of the problem
+  */
+  template <typename Centers>
+  void gather(const Centers& centers, int n, std::vector<int>& candidates, std::vector<char>& marks) const {
+    marks.assign(n, 0);
+    for (int c{0}; c < centers.size(); ++c) {
+      const int* list = (*this)[centers.index(c)];
+      for (int p{0}; p < size_; ++p) {
+        marks[list[p]] = 1;
+      }
+    }
+    candidates.clear();
+    for (int j{0}; j < n; ++j) {
+      if (marks[j] && !centers.contains(j)) candidates.push_back(j);
+    }
+  }
+
+ private:
+  int size_;
+  std::vector<int> neighbors_;  // size_ por punto, seguidos
+};
+
+/**
+ * @brief Uses the nearest and second nearest service point of every point,
+ *        kept by a DistanceIndex. With them the change of the objective for
+ *        removing any service point r and adding a candidate u is, for every
+ *        r at once:
+ *          delta(r, u) = loss[r] - gain(u)
+ *          gain(u) = sum of d1(i) - d(i, u) over the points closer to u
+ *          loss[r] = sum of min(d(i, u), d2(i)) - d1(i) over the other
+ *                    points whose nearest service point is r
+ *        so the whole neighbourhood costs O(n·(n + k)) distance evaluations.
+ *        This is the decomposition of Resende and Werneck without their
+ *        incremental tables: each candidate still takes one O(n) pass over
+ *        the points, so a scan is O(n·(n - k)) and a best improvement search
+ *        pays it again after every accepted move, instead of updating only
+ *        the points whose nearest or second nearest service point changed.
+ *        Those tables need an extra(r, u) entry per service point and
+ *        candidate, O(k·(n - k)) memory, as much as the distance matrix for
+ *        k = n / 10. Candidate lists reduce the candidates per scan instead.
+ *        Centers is the p-median solution: size(), operator[], index(c),
+ *        contains(j) and replace(c, j)
+*/
+template <typename Centers>
+class SwapEngine {
+ public:
+  /**
+   * @brief Swap of the service point at position `out` of the solution for
+   *        the point `in` of the problem
+  */
+  struct Move {
+    int out{-1};
+    int in{-1};
+    double delta{0};  // Cambio de la suma de distancias
+  };
+
+  /**
+   * @brief Creates the engine over the service points of a solution
+   * @param problem Problem
+   * @param centers Service points; apply() modifies them
+   * @param distances Distances of the problem to centers; apply() updates them
+   * @param point_distances Distances between points of the problem
+   * @param loss Scratch buffer of the caller, resized to centers.size()
+   * @param control Limits of the solver, or null. When it asks to stop, a
+   *                scan returns the best swap of the candidates seen so far
+  */
+  SwapEngine(const Problem& problem, Centers& centers, DistanceIndex& distances,
+             const PointDistances& point_distances, std::vector<double>& loss,
+             const SolverControl* control = nullptr)
+      : problem_(problem), centers_(centers), distances_(distances), point_distances_(point_distances),
+        loss_(loss), control_(control) {
+    loss_.resize(centers.size());
+  }
+
+  /**
+   * @brief Best swap of the neighbourhood (lowest delta; ties go to the
+   *        lowest service point and then to the lowest candidate)
+   * @param candidates Points that may come in, in increasing order, or null
+   *                   for every point of the problem
+  */
+  Move best_swap(const std::vector<int>* candidates = nullptr) {
+    return scan(candidates, -INFINITY, 0);
+  }
+
+  /**
+   * @brief First candidate with a swap whose delta is below `threshold`,
+   *        with its best service point; the best swap if there is none. Each
+   *        call resumes the scan after the candidate of the previous one, so
+   *        the first candidates are not always favoured
+  */
+  Move first_swap(double threshold, const std::vector<int>* candidates = nullptr) {
+    return scan(candidates, threshold, cursor_);
+  }
+
+  /**
+   * @brief Applies a swap to the service points and to the distances. Only
+   *        the points that lose their nearest or second nearest are left to
+   *        repair, the next time the second nearest is needed
+  */
+  void apply(const Move& move) {
+    centers_.replace(move.out, move.in);
+    distances_.replace_center(problem_, centers_, move.out);
+  }
+
+ private:
+  const Problem& problem_;
+  Centers& centers_;
+  DistanceIndex& distances_;
+  const PointDistances& point_distances_;
+  std::vector<double>& loss_;  // Pérdida de quitar cada punto de servicio
+  const SolverControl* control_;
+  int cursor_{0};              // Posición de los candidatos donde sigue first_swap
+
+  /**
+   * @brief Evaluates the candidates from position `start` (wrapping around)
+   *        until one has a swap below `threshold`
+  */
+  Move scan(const std::vector<int>* candidates, double threshold, int start) {
+    Move best;
+    best.delta = INFINITY;
+    int k = centers_.size();
+    distances_.repair(problem_, centers_);
+    int count = candidates ? candidates->size() : problem_.size();
+    for (int step{0}; step < count; ++step) {  // por cada candidato
+      int position = (start + step) % count;
+      int u = candidates ? (*candidates)[position] : position;
+      if (centers_.contains(u)) continue;
+      if (control_ && control_->stop_requested()) break;
+      INSTRUMENT_COUNT(kEvaluations, k);
+      double gain{0};
+      std::fill(loss_.begin(), loss_.end(), 0);
+      for (int i{0}; i < problem_.size(); ++i) {  // por cada punto
+        const DistanceIndex::Entry& entry = distances_[i];
+        double distance{point_distances_(i, u)};
+        if (distance < entry.distance) {
+          gain += entry.distance - distance;
+        } else {
+          loss_[entry.center] += std::min(distance, entry.second_distance) - entry.distance;
+        }
+      }
+      for (int r{0}; r < k; ++r) {  // por cada punto de la solución
+        double delta = loss_[r] - gain;
+        if (delta < best.delta || (delta == best.delta && r < best.out)) {
+          best = {r, u, delta};
+        }
+      }
+      if (best.delta < threshold) {
+        cursor_ = (position + 1) % count;
+        break;
+      }
+    }
+    return best;
+  }
+};
+
+#endif  // FAST_SWAP_H
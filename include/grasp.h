@@ -15,72 +15,125 @@
 #define GRASP_H
 
 #include <vector>
+#include <map>
 #include <set>
 #include <random>
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <mutex>
+#include <climits>
 #include "solution.h"
+#include "constructive.h"
+#include "distance-matrix.h"
+#include "thread-pool.h"
+#include "instrumentation.h"
+
+/**
+ * @brief Options of the GRASP algorithm
+*/
+struct GraspOptions {
+  int threads{1};  // Hilos del pool, incluido el llamador (0 = todos los del sistema)
+  std::optional<unsigned> seed;  // Semilla fija: mismos resultados con cualquier número de hilos
+  int max_iterations_without_improvement{200};
+  DistanceOptions distances;  // Origen de las distancias entre puntos
+  LocalSearchOptions local_search;  // Estrategia del postprocesamiento
+  SolverControl control;  // Plazo, cancelación y aviso de cada mejora del incumbente
+};
 
 class Grasp {
  public:
-  Grasp();
+  Grasp(const GraspOptions& options = GraspOptions());
   std::vector<Solution> solve(const Problem& points, int k, int lrc_size);
+ private:
+  GraspOptions options_;
+  std::shared_ptr<ThreadPool> pool_;
 };
 
-Grasp::Grasp() {}
+Grasp::Grasp(const GraspOptions& options)
+    : options_(options), pool_(std::make_shared<ThreadPool>(options.threads)) {}
 
+/**
+ * @brief Runs construction + local search iterations on every thread of the
+ *        pool. Each thread takes the next iteration number when it finishes
+ *        one, so slow iterations do not hold the others back. Iteration i
+ *        draws its random numbers from its own generator, seeded with
+ *        (seed, i), and the results are accepted in iteration order: the
+ *        incumbent, the non-improvement budget and the returned history are
+ *        the same for any number of threads. The control of the options
+ *        stops it early, after at least one iteration
+ * @return Every improvement of the incumbent, in order
+ */
 std::vector<Solution> Grasp::solve(const Problem& points, int k, int lrc_size) {
-  //Preprocesamiento
+  INSTRUMENT_SCOPE(kGrasp);
+  std::random_device rd;
+  unsigned seed = options_.seed ? *options_.seed : rd();
   std::vector<Solution> solutions;
+  std::atomic<double> incumbent{INFINITY};  // Valor de la mejor solución aceptada
+  std::atomic<int> next_iteration{0};
+  std::atomic<int> stop_iteration{INT_MAX};  // Primera iteración que ya no hace falta
+  // Resultados que esperan a que terminen las iteraciones anteriores
+  std::mutex mutex;
+  std::map<int, std::optional<std::pair<Solution, double>>> pending;
+  int next_accepted{0};
   int condition{0};
-  while(condition < 200) {
-    // Fase constructiva
-    // Seleccionar un punto aleatorio como solución inicial
-    Solution solution(points.dimensions());
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, points.size() - 1);
-    solution.push_back(points[dis(gen)]);
-    // Mientras no se haya alcanzado el número de puntos de servicio
-    while (solution.size() < k) {
-      std::vector<int> lrc;
-      std::vector<double> distances(points.size());
-      // Buscamos la distancia mínima de cada punto a la solución
-      // Añadimos al LRC los puntos con la distancia mínima más alta
-      for (int i{0}; i < points.size(); ++i) { // Para cada punto
-        for (int j{0}; j < solution.size(); ++j) { // Para cada punto de la solución
-          double distance{euclidean_distance(points[i], solution[j])};
-          if (distance < distances[i]) {
-            distances[i] = distance;
-          }
-        }
-      }
-      // Ordenamos los puntos por distancia
-      std::vector<int> sorted_points(points.size());
-      std::iota(sorted_points.begin(), sorted_points.end(), 0);
-      std::sort(sorted_points.begin(), sorted_points.end(), [&distances](int a, int b) {
-        return distances[a] < distances[b];
-      });
-      // Añadimos los puntos al LRC
-      for (int i{0}; i < lrc_size; ++i) {
-        lrc.push_back(sorted_points[i]);
-      }
-      // Seleccionamos un punto aleatorio del LRC
-      std::uniform_int_distribution<> dis2(0, lrc.size() - 1);
-      solution.push_back(points[lrc[dis2(gen)]]);
-    }
+  DistanceBackendSet backends(points, options_.distances, *pool_, &options_.control);
+  std::shared_ptr<const CandidateLists> candidate_lists;
+  if (options_.local_search.candidate_list_size > 0) {
+    candidate_lists = std::make_shared<const CandidateLists>(points, options_.local_search.candidate_list_size,
+                                                             *pool_, &options_.control);
+  }
 
-    // Postprocesamiento
-    solution = solution.local_search(points);
+  pool_->parallel_for(pool_->size(), [&](int) {
+    std::unique_ptr<DistanceTileCache> cache = backends.make_cache();
+    PointDistances distances = backends.distances(cache.get());
+    GreedyConstructor constructor(points, distances, &options_.control);
+    // Solución y memoria de la búsqueda local de este hilo, reutilizadas en cada iteración
+    Solution solution(points);
+    SearchWorkspace workspace;
+    workspace.candidate_lists = candidate_lists;
+    workspace.control = &options_.control;
+    int iteration;
+    while (true) {
+      // La primera iteración siempre se hace, para tener una solución válida
+      if (next_iteration.load() > 0 && options_.control.stop_requested()) break;
+      if ((iteration = next_iteration.fetch_add(1)) >= stop_iteration.load()) break;
+      std::seed_seq sequence{seed, unsigned(iteration)};
+      std::mt19937 gen(sequence);
+      // Fase constructiva
+      constructor.construct(k, lrc_size, gen, solution);
+      // Postprocesamiento
+      double value = solution.improve(points, distances, workspace, options_.local_search, &gen);
+      std::optional<std::pair<Solution, double>> result;
+      // El incumbente solo baja: si no lo mejora ahora, tampoco lo hará al aceptarla
+      if (value < incumbent.load()) {
+        result.emplace(solution, value);
+      }
 
-    // Actualización de la solución
-    condition++;
-    if (solutions.empty() || solution.evaluate(points) < solutions[solutions.size() - 1].evaluate(points)) {
-      solutions.push_back(solution);
-      condition = 0;
+      // Actualización de la solución, en el orden de las iteraciones
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.emplace(iteration, std::move(result));
+      while (!pending.empty() && pending.begin()->first == next_accepted &&
+             next_accepted < stop_iteration.load()) {
+        std::optional<std::pair<Solution, double>>& accepted = pending.begin()->second;
+        condition++;
+        if (accepted && accepted->second < incumbent.load()) {
+          solutions.push_back(std::move(accepted->first));
+          incumbent.store(accepted->second);
+          condition = 0;
+          if (options_.control.on_improvement) options_.control.on_improvement(solutions.back(), accepted->second);
+        }
+        pending.erase(pending.begin());
+        ++next_accepted;
+        if (condition >= options_.max_iterations_without_improvement) {
+          stop_iteration.store(next_accepted);
+        }
+      }
     }
-  }
+  });
   return solutions;
 }
 
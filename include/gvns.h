@@ -20,108 +20,232 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <mutex>
 #include "solution.h"
+#include "constructive.h"
+#include "distance-matrix.h"
+#include "thread-pool.h"
+#include "instrumentation.h"
+
+/**
+ * @brief Options of the GVNS algorithm
+*/
+struct GVNSOptions {
+  int threads{1};  // Trayectorias simultáneas, una por hilo (0 = todos los del sistema)
+  std::optional<unsigned> seed;  // Semilla fija: resultados reproducibles con un solo hilo
+  int max_iterations_without_improvement{200};  // Sin mejorar el incumbente, entre todos los hilos
+  int max_iterations{3000};  // Iteraciones entre todos los hilos
+  int lrc_size{3};  // LRC de la fase constructiva
+  DistanceOptions distances;  // Origen de las distancias entre puntos
+  LocalSearchOptions local_search;  // Estrategia de la búsqueda local tras cada sacudida
+  SolverControl control;  // Plazo, cancelación y aviso de cada mejora del incumbente
+};
 
 class GVNS {
  public:
-  GVNS();
+  GVNS(const GVNSOptions& options = GVNSOptions());
   std::vector<Solution> solve(const Problem& points, int k, bool rvnd = false);
+ private:
+  /**
+   * @brief Last solution that a trajectory published. Only its owner writes
+   *        it, and only another trajectory that moves to it reads it
+  */
+  struct Slot {
+    std::mutex mutex;
+    std::optional<Solution> solution;
+    double value{INFINITY};
+  };
+
+  GVNSOptions options_;
+  std::shared_ptr<ThreadPool> pool_;
 };
 
-GVNS::GVNS() {}
+GVNS::GVNS(const GVNSOptions& options)
+    : options_(options), pool_(std::make_shared<ThreadPool>(options.threads)) {}
 
+/**
+ * @brief Runs one GVNS trajectory per thread of the pool, each from its own
+ *        constructed solution and random stream. The incumbent is an atomic
+ *        value lowered with compare-and-swap, plus the index of the
+ *        trajectory whose slot holds its solution, so publishing never waits
+ *        for the other trajectories. A trajectory that finishes a whole
+ *        shaking cycle without improving copies the incumbent if it is
+ *        better, locking only that slot, so the threads shake around the
+ *        best solution known. on_improvement is called outside every lock
+ *        of the search: whichever trajectory finds it free reports the
+ *        pending improvements, in order. The iteration budgets are shared, so more
+ *        threads reach them sooner. The control of the options stops every
+ *        trajectory early, even in the middle of a local search
+ * @param rvnd Explore the neighbourhoods of the local search in random order
+ *             (RVND) instead of in a fixed one (VND)
+ * @return Every improvement of the incumbent, in order
+ */
 std::vector<Solution> GVNS::solve(const Problem& points, int k, bool rvnd) {
+  INSTRUMENT_SCOPE(kGVNS);
   //Preprocesamiento
   std::vector<Solution> solutions;
-
-  // Construimos una solución aleatoria con la fase constructiva de GRASP
-  Solution solution(points.dimensions());
+  std::vector<double> values;  // Objetivo de cada solución de solutions
+  std::mutex solutions_mutex;
+  std::atomic<double> incumbent{INFINITY};  // Valor del incumbente
+  std::atomic<int> incumbent_slot{-1};  // Trayectoria con la solución del incumbente
+  std::vector<Slot> slots(pool_->size());
+  std::atomic<int> iterations_without_improvement{0};
+  std::atomic<int> iterations{0};
   std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<> dis(0, points.size() - 1);
-  solution.push_back(points[dis(gen)]);
-  // Mientras no se haya alcanzado el número de puntos de servicio
-  while (solution.size() < k) {
-    std::vector<int> lrc;
-    std::vector<double> distances(points.size());
-    // Buscamos la distancia mínima de cada punto a la solución
-    // Añadimos al LRC los puntos con la distancia mínima más alta
-    for (int i{0}; i < points.size(); ++i) { // Para cada punto
-      for (int j{0}; j < solution.size(); ++j) { // Para cada punto de la solución
-        double distance{euclidean_distance(points[i], solution[j])};
-        if (distance < distances[i]) {
-          distances[i] = distance;
+  unsigned seed = options_.seed ? *options_.seed : rd();
+  auto finished = [&]() {
+    return iterations_without_improvement.load() >= options_.max_iterations_without_improvement ||
+           iterations.load() >= options_.max_iterations ||
+           options_.control.stop_requested();
+  };
+  // Avisa de las mejoras pendientes si ningún otro hilo lo está haciendo ya
+  std::mutex report_mutex;
+  size_t reported{0};  // Soluciones ya avisadas, protegido por solutions_mutex
+  auto report = [&]() {
+    if (!options_.control.on_improvement) return;
+    std::unique_lock<std::mutex> reporting(report_mutex, std::try_to_lock);
+    while (reporting.owns_lock()) {
+      std::optional<std::pair<Solution, double>> next;
+      {
+        std::lock_guard<std::mutex> lock(solutions_mutex);
+        if (reported < solutions.size()) {
+          next.emplace(solutions[reported], values[reported]);
+          ++reported;
         }
       }
+      if (next) {
+        options_.control.on_improvement(next->first, next->second);
+        continue;
+      }
+      reporting.unlock();
+      // Una mejora añadida mientras se soltaba el cerrojo no se queda sin avisar
+      std::lock_guard<std::mutex> lock(solutions_mutex);
+      if (reported == solutions.size()) break;
+      reporting.try_lock();
     }
-    // Ordenamos los puntos por distancia
-    std::vector<int> sorted_points(points.size());
-    std::iota(sorted_points.begin(), sorted_points.end(), 0);
-    std::sort(sorted_points.begin(), sorted_points.end(), [&distances](int a, int b) {
-      return distances[a] < distances[b];
-    });
-    // Añadimos los puntos al LRC
-    for (int i{0}; i < 3; ++i) {
-      lrc.push_back(sorted_points[i]);
+  };
+  // Publica una solución si mejora el incumbente; devuelve si lo ha hecho
+  auto publish = [&](int worker, const Solution& solution, double value) {
+    double current = incumbent.load();
+    if (!(value < current)) return false;
+    {
+      std::lock_guard<std::mutex> lock(slots[worker].mutex);
+      slots[worker].solution = solution;
+      slots[worker].value = value;
+    }
+    while (value < current) {
+      if (incumbent.compare_exchange_weak(current, value)) {
+        incumbent_slot.store(worker);
+        iterations_without_improvement.store(0);
+        {
+          std::lock_guard<std::mutex> lock(solutions_mutex);
+          // Otro hilo puede haber publicado antes una solución aún mejor
+          if (values.empty() || value < values.back()) {
+            solutions.push_back(solution);
+            values.push_back(value);
+          }
+        }
+        report();
+        return true;
+      }
     }
-    // Seleccionamos un punto aleatorio del LRC
-    std::uniform_int_distribution<> dis2(0, lrc.size() - 1);
-    solution.push_back(points[lrc[dis2(gen)]]);
+    return false;
+  };
+
+  DistanceBackendSet backends(points, options_.distances, *pool_, &options_.control);
+  // Con rvnd los vecindarios de la búsqueda local se recorren en orden aleatorio
+  LocalSearchOptions local_search = options_.local_search;
+  local_search.random_order = local_search.random_order || rvnd;
+  std::shared_ptr<const CandidateLists> candidate_lists;
+  if (local_search.candidate_list_size > 0) {
+    candidate_lists = std::make_shared<const CandidateLists>(points, local_search.candidate_list_size, *pool_,
+                                                             &options_.control);
   }
 
-  int iterations_without_improvement{0};
-  int iterations{0};
-  int shake_size{1};
-  while(iterations_without_improvement < 200 && iterations < 3000) {
-    shake_size = 1;
-    while (shake_size <= solution.size()) {
-      Solution new_solution = solution;
-      // Shaking
-      // Seleccionamos aleatoriamente shake_size puntos de la solución
-      std::vector<int> selected_points;
-      std::uniform_int_distribution<> dis3(0, new_solution.size() - 1);
-      while (selected_points.size() < shake_size) {
-        int point{dis3(gen)};
-        if (std::find(selected_points.begin(), selected_points.end(), point) == selected_points.end()) {
-          selected_points.push_back(point);
+  pool_->parallel_for(pool_->size(), [&](int worker) {
+    std::seed_seq sequence{seed, unsigned(worker)};
+    std::mt19937 gen(sequence);
+    std::unique_ptr<DistanceTileCache> cache = backends.make_cache();
+    PointDistances distances = backends.distances(cache.get());
+    // Construimos una solución aleatoria con la fase constructiva de GRASP
+    Solution solution = GreedyConstructor(points, distances, &options_.control).construct(k, options_.lrc_size, gen);
+    // Memoria de este hilo reutilizada en cada vecindario: la solución de prueba se
+    // restaura desde la actual en lugar de copiarse, y se intercambia con ella al aceptarla
+    SearchWorkspace workspace;
+    workspace.candidate_lists = candidate_lists;
+    workspace.control = &options_.control;
+    Solution new_solution(solution);
+    std::vector<int> selected_points;
+    std::vector<int> new_problem_points;
+    double value = solution.evaluate(points, workspace.distances);
+    publish(worker, solution, value);
+
+    int shake_size{1};
+    while (!finished()) {
+      bool improved{false};
+      shake_size = 1;
+      while (shake_size <= solution.size() && !finished()) {
+        new_solution = solution;
+        // Shaking
+        {
+          INSTRUMENT_SCOPE(kShaking);
+          // Seleccionamos aleatoriamente shake_size puntos de la solución
+          selected_points.clear();
+          std::uniform_int_distribution<> dis3(0, new_solution.size() - 1);
+          while (int(selected_points.size()) < shake_size) {
+            int point{dis3(gen)};
+            if (std::find(selected_points.begin(), selected_points.end(), point) == selected_points.end()) {
+              selected_points.push_back(point);
+            }
+          }
+          // Seleccionamos aleatoriamente shake_size puntos de los puntos que no están en la solución
+          new_problem_points.clear();
+          std::uniform_int_distribution<> dis4(0, points.size() - 1);
+          while (int(new_problem_points.size()) < shake_size) {
+            int point{dis4(gen)};
+            if ((std::find(new_problem_points.begin(), new_problem_points.end(), point) == new_problem_points.end()) &&
+              !new_solution.contains(point)) {
+              new_problem_points.push_back(point);
+            }
+          }
+          // Intercambiamos los puntos seleccionados
+          for (int i{0}; i < shake_size; ++i) {
+            new_solution.replace(selected_points[i], new_problem_points[i]);
+          }
         }
-      }
-      // Seleccionamos aleatoriamente shake_size puntos de los puntos que no están en la solución
-      std::vector<int> new_problem_points;
-      std::uniform_int_distribution<> dis4(0, points.size() - 1);
-      while (new_problem_points.size() < shake_size) {
-        int point{dis4(gen)};
-        if ((std::find(selected_points.begin(), selected_points.end(), point) == selected_points.end()) &&
-          !new_solution.isInSolution(points[point])) {
-          new_problem_points.push_back(point);
+
+        double new_value = new_solution.improve(points, distances, workspace, local_search, &gen);
+        // Movimiento
+        if (new_value < value) {
+          std::swap(solution, new_solution);
+          value = new_value;
+          improved = true;
+          shake_size = 1;
+        } else {
+          shake_size++;
         }
       }
-      // Intercambiamos los puntos seleccionados
-      for (int i{0}; i < shake_size; ++i) {
-        new_solution[selected_points[i]] = points[new_problem_points[i]];
+      // Actualización de la solución
+      iterations_without_improvement++;
+      iterations++;
+      if (improved) {
+        publish(worker, solution, value);
       }
-
-      if (rvnd) {
-        // new_solution = new_solution.rvnd(points);
-      } else {
-        new_solution = new_solution.local_search(points);
-      }
-      // Movimiento
-      if (new_solution.evaluate(points) < solution.evaluate(points)) {
-        solution = new_solution;
-        shake_size = 1;
-      } else {
-        shake_size++;
+      // Cooperación: sin mejoras propias, se continúa desde el incumbente
+      int best = incumbent_slot.load();
+      if (!improved && best >= 0 && best != worker && incumbent.load() < value) {
+        std::lock_guard<std::mutex> lock(slots[best].mutex);
+        if (slots[best].value < value) {
+          solution = *slots[best].solution;
+          value = slots[best].value;
+        }
       }
     }
-    // Actualización de la solución
-    iterations_without_improvement++;
-    iterations++;
-    if (solutions.empty() || solution.evaluate(points) < solutions[solutions.size() - 1].evaluate(points)) {
-      solutions.push_back(solution);
-      iterations_without_improvement = 0;
-    }
-  }
+  });
+  report();
   return solutions;
   
   // RVNS
@@ -0,0 +1,63 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file instance-generator.h
+ * @brief Synthetic instances
+ *        This file contains the seeded generators of uniform and Gaussian
+ *        blob instances used by the benchmarks
+ */
+
+#ifndef INSTANCE_GENERATOR_H
+#define INSTANCE_GENERATOR_H
+
+#include <vector>
+#include <random>
+#include "problem.h"
+
+/**
+ * @brief m points of d dimensions drawn uniformly from [0, side)^d
+ * @param seed Same seed, same instance on every platform with the same
+ *             standard library
+ */
+inline Problem generate_uniform(int m, int d, unsigned seed, double side = 10) {
+  Problem problem(m, d);
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> coordinate(0, side);
+  for (int i{0}; i < m; ++i) {
+    for (int j{0}; j < d; ++j) {
+      problem[i][j] = coordinate(gen);
+    }
+  }
+  return problem;
+}
+
+/**
+ * @brief m points of d dimensions around `blobs` centers drawn uniformly from
+ *        [0, side)^d, each point from a normal of deviation `spread` around a
+ *        center chosen uniformly
+ */
+inline Problem generate_blobs(int m, int d, int blobs, unsigned seed, double spread = 0.5, double side = 10) {
+  Problem problem(m, d);
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> coordinate(0, side);
+  std::vector<double> centers(size_t(blobs) * d);
+  for (double& value: centers) {
+    value = coordinate(gen);
+  }
+  std::uniform_int_distribution<> blob(0, blobs - 1);
+  std::normal_distribution<> noise(0, spread);
+  for (int i{0}; i < m; ++i) {
+    const double* center = centers.data() + size_t(blob(gen)) * d;
+    for (int j{0}; j < d; ++j) {
+      problem[i][j] = center[j] + noise(gen);
+    }
+  }
+  return problem;
+}
+
+#endif  // INSTANCE_GENERATOR_H
@@ -0,0 +1,326 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file instance-io.h
+ * @brief Instance input/output
+ *        This file contains the readers of the text and binary instance
+ *        formats and the writer of the binary one
+ */
+
+#ifndef INSTANCE_IO_H
+#define INSTANCE_IO_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <stdexcept>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "problem.h"
+#include "thread-pool.h"
+
+/**
+ * @brief Header of the binary instance format. The coordinates follow at
+ *        data_offset, row-major and little-endian, so the file can be mapped
+ *        straight into a Problem
+*/
+struct BinaryInstanceHeader {
+  char magic[8];          // "KMEANSB" terminado en '\0'
+  std::uint32_t version;  // 1
+  std::uint32_t dtype;    // BinaryDtype
+  std::uint64_t points;   // m
+  std::uint64_t dimensions;  // n
+  std::uint64_t alignment;   // Alineación en bytes de data_offset
+  std::uint64_t data_offset;
+  char reserved[16];
+};
+
+static_assert(sizeof(BinaryInstanceHeader) == 64, "The binary header must take 64 bytes");
+
+enum BinaryDtype : std::uint32_t { kFloat64 = 1, kFloat32 = 2 };
+
+const char kBinaryMagic[8] = {'K', 'M', 'E', 'A', 'N', 'S', 'B', '\0'};
+
+/**
+ * @brief Binary type of the coordinates of a BasicProblem<T>
+*/
+template <typename T>
+constexpr BinaryDtype binary_dtype() {
+  return std::is_same<T, float>::value ? kFloat32 : kFloat64;
+}
+
+/**
+ * @brief Read-only view of a whole file, unmapped when the last copy goes away
+*/
+class MappedFile {
+ public:
+  /**
+   * @brief Maps a file
+   * @param path File to map
+   * @param writable Private copy-on-write pages instead of read-only ones
+  */
+  MappedFile(const std::string& path, bool writable = false) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      throw std::runtime_error("Error opening file " + path);
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+      close(descriptor);
+      throw std::runtime_error("Error reading file " + path);
+    }
+    size_ = status.st_size;
+    void* address = nullptr;
+    if (size_ > 0) {
+      address = mmap(nullptr, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+    close(descriptor);
+    if (address == MAP_FAILED) {
+      throw std::runtime_error("Error mapping file " + path);
+    }
+    size_t size = size_;
+    mapping_ = std::shared_ptr<void>(address, [size](void* memory) {
+      if (memory != nullptr) munmap(memory, size);
+    });
+  }
+
+  char* data() const {
+    return static_cast<char*>(mapping_.get());
+  }
+
+  const size_t size() const {
+    return size_;
+  }
+
+  /**
+   * @brief Keeps the mapping alive
+  */
+  const std::shared_ptr<void>& owner() const {
+    return mapping_;
+  }
+
+ private:
+  std::shared_ptr<void> mapping_;
+  size_t size_{0};
+};
+
+/**
+ * @brief True if the file starts with the magic of the binary format
+*/
+bool is_binary_instance(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kBinaryMagic)] = {};
+  file.read(magic, sizeof(magic));
+  return file && std::memcmp(magic, kBinaryMagic, sizeof(magic)) == 0;
+}
+
+/**
+ * @brief Reads and validates the header of a binary instance of `size`
+ *        bytes. The counts must fit in an int and the coordinates they
+ *        describe must fit in the file, so a corrupt header is rejected
+ *        before anything is mapped from it
+*/
+inline BinaryInstanceHeader read_binary_header(const char* data, size_t size, const std::string& path) {
+  if (size < sizeof(BinaryInstanceHeader)) {
+    throw std::runtime_error("Truncated binary instance " + path);
+  }
+  BinaryInstanceHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0 || header.version != 1) {
+    throw std::runtime_error("Unknown binary instance format in " + path);
+  }
+  if ((header.dtype != kFloat64 && header.dtype != kFloat32) || header.points > INT_MAX ||
+      header.dimensions > INT_MAX || header.data_offset % alignof(double) != 0 || header.data_offset > size) {
+    throw std::runtime_error("Invalid binary instance " + path);
+  }
+  // Se compara por divisiones para que un producto desbordado no pase la comprobación
+  size_t value_size = header.dtype == kFloat32 ? sizeof(float) : sizeof(double);
+  size_t available = (size - header.data_offset) / value_size;
+  if (header.dimensions > 0 && header.points > available / header.dimensions) {
+    throw std::runtime_error("Truncated binary instance " + path);
+  }
+  return header;
+}
+
+/**
+ * @brief True if the coordinates of a binary instance can be mapped into an
+ *        AlignedBuffer: the header must declare STORAGE_ALIGNMENT (or a
+ *        multiple) and data_offset must honour it. The mapping starts on a
+ *        page, so the offset alone decides where the data lands
+*/
+inline bool is_mappable(const BinaryInstanceHeader& header) {
+  return header.alignment != 0 && header.alignment % STORAGE_ALIGNMENT == 0 &&
+         header.data_offset % STORAGE_ALIGNMENT == 0;
+}
+
+/**
+ * @brief Loads a binary instance. Data stored in the precision of the
+ *        problem and aligned as is_mappable() requires is mapped
+ *        copy-on-write into it without any copy; any other data is copied,
+ *        converting it if it is in the other precision
+*/
+template <typename T = double>
+BasicProblem<T> load_binary_instance(const std::string& path) {
+  MappedFile file(path, true);
+  BinaryInstanceHeader header = read_binary_header(file.data(), file.size(), path);
+  size_t values = size_t(header.points) * header.dimensions;
+  char* data = file.data() + header.data_offset;
+  if (header.dtype == binary_dtype<T>() && is_mappable(header)) {
+    madvise(file.data(), file.size(), MADV_WILLNEED);
+    return BasicProblem<T>(header.points, header.dimensions,
+                           AlignedBuffer<T>(reinterpret_cast<T*>(data), values, file.owner()));
+  }
+  BasicProblem<T> problem(header.points, header.dimensions);
+  if (header.dtype == kFloat32) {
+    const float* source = reinterpret_cast<const float*>(data);
+    std::copy(source, source + values, problem.data());
+  } else {
+    const double* source = reinterpret_cast<const double*>(data);
+    std::copy(source, source + values, problem.data());
+  }
+  return problem;
+}
+
+/**
+ * @brief Writes a problem in the binary format
+ * @param dtype kFloat64 keeps the coordinates exact, kFloat32 halves the file
+*/
+template <typename T>
+void write_binary_instance(const std::string& path, const BasicProblem<T>& problem, BinaryDtype dtype = kFloat64) {
+  BinaryInstanceHeader header{};
+  std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+  header.version = 1;
+  header.dtype = dtype;
+  header.points = problem.size();
+  header.dimensions = problem.dimensions();
+  header.alignment = STORAGE_ALIGNMENT;
+  header.data_offset = STORAGE_ALIGNMENT;  // La cabecera ocupa justo una línea de caché
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  size_t values = size_t(problem.size()) * problem.dimensions();
+  if (dtype == binary_dtype<T>()) {
+    file.write(reinterpret_cast<const char*>(problem.data()), values * sizeof(T));
+  } else if (dtype == kFloat64) {
+    std::vector<double> widened(problem.data(), problem.data() + values);
+    file.write(reinterpret_cast<const char*>(widened.data()), values * sizeof(double));
+  } else {
+    std::vector<float> narrowed(problem.data(), problem.data() + values);
+    file.write(reinterpret_cast<const char*>(narrowed.data()), values * sizeof(float));
+  }
+  if (!file) {
+    throw std::runtime_error("Error writing binary instance " + path);
+  }
+}
+
+namespace text_parser {
+
+inline bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * @brief Number of whitespace-separated tokens in [begin, end)
+*/
+inline size_t count_tokens(const char* begin, const char* end) {
+  size_t tokens{0};
+  bool in_token{false};
+  for (const char* c = begin; c < end; ++c) {
+    bool space = is_space(*c);
+    tokens += !space && !in_token;
+    in_token = !space;
+  }
+  return tokens;
+}
+
+/**
+ * @brief Parses the next token of [*cursor, end) as a number
+*/
+template <typename T>
+T next_number(const char*& cursor, const char* end, const std::string& path) {
+  while (cursor < end && is_space(*cursor)) ++cursor;
+  if (cursor < end && *cursor == '+') ++cursor;
+  T value{};
+  std::from_chars_result result = std::from_chars(cursor, end, value);
+  if (result.ec != std::errc()) {
+    throw std::runtime_error("Invalid number in " + path);
+  }
+  cursor = result.ptr;
+  return value;
+}
+
+}  // namespace text_parser
+
+/**
+ * @brief Loads an instance in the text format of examples/. The file is
+ *        mapped and split in chunks at whitespace; the threads first count
+ *        the numbers of their chunk, so each one knows where its points go,
+ *        and then parse them straight into the problem
+ * @param threads Parser threads (0 = all the cores)
+*/
+template <typename T = double>
+BasicProblem<T> load_text_instance(const std::string& path, int threads = 0) {
+  MappedFile file(path);
+  const char* cursor = file.data();
+  const char* end = file.data() + file.size();
+  int m = text_parser::next_number<int>(cursor, end, path);
+  int n = text_parser::next_number<int>(cursor, end, path);
+  BasicProblem<T> problem(m, n);
+  size_t values = size_t(m) * n;
+
+  ThreadPool pool(threads);
+  int chunks = std::max<size_t>(1, std::min<size_t>(pool.size() * 4, (end - cursor) / (1 << 16)));
+  // Los límites de los trozos se mueven hasta un separador para no partir números
+  std::vector<const char*> bounds(chunks + 1, end);
+  bounds[0] = cursor;
+  for (int chunk{1}; chunk < chunks; ++chunk) {
+    const char* bound = cursor + (end - cursor) * chunk / chunks;
+    while (bound < end && !text_parser::is_space(*bound)) ++bound;
+    bounds[chunk] = std::max(bound, bounds[chunk - 1]);
+  }
+  std::vector<size_t> first_value(chunks + 1, 0);
+  pool.parallel_for(chunks, [&](int chunk) {
+    first_value[chunk + 1] = text_parser::count_tokens(bounds[chunk], bounds[chunk + 1]);
+  });
+  for (int chunk{0}; chunk < chunks; ++chunk) {
+    first_value[chunk + 1] += first_value[chunk];
+  }
+  if (first_value[chunks] < values) {
+    throw std::runtime_error("Unexpected end of file " + path);
+  }
+  pool.parallel_for(chunks, [&](int chunk) {
+    const char* position = bounds[chunk];
+    size_t last = std::min(first_value[chunk + 1], values);
+    T* out = problem.data();
+    for (size_t value{first_value[chunk]}; value < last; ++value) {
+      out[value] = text_parser::next_number<T>(position, bounds[chunk + 1], path);
+    }
+  });
+  return problem;
+}
+
+/**
+ * @brief Loads an instance in any of the supported formats
+ * @tparam T Precision of the problem, whatever the precision of the file
+*/
+template <typename T = double>
+BasicProblem<T> load_instance(const std::string& path, int threads = 0) {
+  if (is_binary_instance(path)) {
+    return load_binary_instance<T>(path);
+  }
+  return load_text_instance<T>(path, threads);
+}
+
+#endif  // INSTANCE_IO_H
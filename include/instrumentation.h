@@ -0,0 +1,302 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file instrumentation.h
+ * @brief Instrumentation of the solvers
+ *        This file contains the phase timers and event counters of the hot
+ *        paths. They are compiled in only with -DKMEANS_INSTRUMENT
+ *        (make INSTRUMENT=1); otherwise the macros expand to nothing
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+
+namespace instrumentation {
+
+#ifdef KMEANS_INSTRUMENT
+constexpr bool kEnabled{true};
+#else
+constexpr bool kEnabled{false};
+#endif
+
+/**
+ * @brief Instrumented phases. A phase opened inside another is nested in it
+*/
+enum class Phase { kNone, kKMeans, kGrasp, kGVNS, kConstruction, kShaking, kLocalSearch,
+                   kSwap, kInsertion, kElimination, kCount };
+
+/**
+ * @brief Counted events
+ *        kEvaluations: neighbours evaluated
+ *        kMoves: moves applied
+ *        kDistances: distances computed by the kernels
+ *        kLookups: point to point distances read from a PointDistances
+ *        kCopies: Solution copies (moves are not counted)
+*/
+enum class Counter { kEvaluations, kMoves, kDistances, kLookups, kCopies, kCount };
+
+constexpr int kPhases{int(Phase::kCount)};
+constexpr int kCounters{int(Counter::kCount)};
+
+inline const char* phase_name(Phase phase) {
+  static const char* names[kPhases] = {"none", "kmeans", "grasp", "gvns", "construction", "shaking",
+                                       "local_search", "swap", "insertion", "elimination"};
+  return names[int(phase)];
+}
+
+inline const char* counter_name(Counter counter) {
+  static const char* names[kCounters] = {"evaluations", "moves", "distances", "lookups", "copies"};
+  return names[int(counter)];
+}
+
+/**
+ * @brief Totals of one phase. The time includes the nested phases; every
+ *        counter goes to the innermost phase open when it was counted
+*/
+struct PhaseTotals {
+  uint64_t calls{0};
+  double seconds{0};
+  uint64_t counters[kCounters]{};
+};
+
+/**
+ * @brief A closed phase, in microseconds since the origin of the registry
+*/
+struct TraceEvent {
+  Phase phase;
+  double start;
+  double duration;
+};
+
+/**
+ * @brief Counters of one thread. Only that thread writes them; they are read
+ *        once the instrumented work has finished
+*/
+struct ThreadRecord {
+  int id;
+  Phase current{Phase::kNone};
+  PhaseTotals totals[kPhases];
+  std::vector<TraceEvent> events;
+};
+
+/**
+ * @brief Records of every thread that counted something. A record outlives
+ *        its thread, so work done by a pool that was destroyed still counts
+*/
+class Registry {
+ public:
+  static Registry& instance() {
+    static Registry registry;
+    return registry;
+  }
+
+  ThreadRecord& attach() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.push_back(std::make_unique<ThreadRecord>());
+    records_.back()->id = records_.size() - 1;
+    return *records_.back();
+  }
+
+  /**
+   * @brief Sum of the totals of every thread
+  */
+  std::vector<PhaseTotals> merge() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<PhaseTotals> merged(kPhases);
+    for (const std::unique_ptr<ThreadRecord>& record: records_) {
+      for (int p{0}; p < kPhases; ++p) {
+        merged[p].calls += record->totals[p].calls;
+        merged[p].seconds += record->totals[p].seconds;
+        for (int c{0}; c < kCounters; ++c) {
+          merged[p].counters[c] += record->totals[p].counters[c];
+        }
+      }
+    }
+    return merged;
+  }
+
+  /**
+   * @brief Clears every record and restarts the trace clock
+  */
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::unique_ptr<ThreadRecord>& record: records_) {
+      for (PhaseTotals& totals: record->totals) {
+        totals = PhaseTotals();
+      }
+      record->events.clear();
+    }
+    origin_ = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * @brief Writes the events of every thread in the Chrome trace event
+   *        format (chrome://tracing, Perfetto)
+  */
+  void write_trace(std::ostream& os) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    os << "{\"traceEvents\": [";
+    bool first{true};
+    for (const std::unique_ptr<ThreadRecord>& record: records_) {
+      for (const TraceEvent& event: record->events) {
+        os << (first ? "\n" : ",\n") << "  {\"name\": \"" << phase_name(event.phase)
+           << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << record->id << std::fixed << std::setprecision(3)
+           << ", \"ts\": " << event.start << ", \"dur\": " << event.duration << "}" << std::defaultfloat;
+        first = false;
+      }
+    }
+    os << "\n]}" << std::endl;
+  }
+
+  bool tracing() const {
+    return tracing_;
+  }
+
+  /**
+   * @brief Keeps an event per closed phase. Set it before the run: the
+   *        threads read it without synchronization
+  */
+  void set_tracing(bool tracing) {
+    tracing_ = tracing;
+  }
+
+  double since_origin(std::chrono::steady_clock::time_point time) const {
+    return std::chrono::duration<double, std::micro>(time - origin_).count();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadRecord>> records_;
+  bool tracing_{false};
+  std::chrono::steady_clock::time_point origin_{std::chrono::steady_clock::now()};
+};
+
+inline ThreadRecord& local() {
+  thread_local ThreadRecord& record = Registry::instance().attach();
+  return record;
+}
+
+inline void count(Counter counter, uint64_t amount) {
+  ThreadRecord& record = local();
+  record.totals[int(record.current)].counters[int(counter)] += amount;
+}
+
+inline Phase current_phase() {
+  return kEnabled ? local().current : Phase::kNone;
+}
+
+/**
+ * @brief Times a phase from its construction to its destruction
+*/
+class Scope {
+ public:
+  explicit Scope(Phase phase) : record_(local()), phase_(phase), previous_(record_.current),
+                                start_(std::chrono::steady_clock::now()) {
+    record_.current = phase;
+  }
+
+  ~Scope() {
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start_).count();
+    PhaseTotals& totals = record_.totals[int(phase_)];
+    ++totals.calls;
+    totals.seconds += seconds;
+    record_.current = previous_;
+    Registry& registry = Registry::instance();
+    if (registry.tracing()) {
+      record_.events.push_back({phase_, registry.since_origin(start_), seconds * 1e6});
+    }
+  }
+
+ private:
+  ThreadRecord& record_;
+  Phase phase_;
+  Phase previous_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Makes a worker thread count into the phase of the thread that gave
+ *        it the work, without timing it again
+*/
+class Adopt {
+ public:
+  explicit Adopt(Phase phase) : record_(local()), previous_(record_.current) {
+    record_.current = phase;
+  }
+
+  ~Adopt() {
+    record_.current = previous_;
+  }
+
+ private:
+  ThreadRecord& record_;
+  Phase previous_;
+};
+
+/**
+ * @brief Member that counts the copies of the object that holds it
+*/
+struct CopyCounter {
+  CopyCounter() {}
+#ifdef KMEANS_INSTRUMENT
+  CopyCounter(const CopyCounter&) { count(Counter::kCopies, 1); }
+  CopyCounter(CopyCounter&&) noexcept {}
+  CopyCounter& operator=(const CopyCounter&) {
+    count(Counter::kCopies, 1);
+    return *this;
+  }
+  CopyCounter& operator=(CopyCounter&&) noexcept { return *this; }
+#endif
+};
+
+/**
+ * @brief Writes the merged totals of every phase that ran, one line each
+*/
+inline void write_report(std::ostream& os) {
+  std::vector<PhaseTotals> totals = Registry::instance().merge();
+  os << "phase,calls,seconds";
+  for (int c{0}; c < kCounters; ++c) {
+    os << "," << counter_name(Counter(c));
+  }
+  os << std::endl;
+  for (int p{0}; p < kPhases; ++p) {
+    bool used = totals[p].calls > 0;
+    for (int c{0}; c < kCounters; ++c) {
+      used = used || totals[p].counters[c] > 0;
+    }
+    if (!used) continue;
+    os << phase_name(Phase(p)) << "," << totals[p].calls << "," << totals[p].seconds;
+    for (int c{0}; c < kCounters; ++c) {
+      os << "," << totals[p].counters[c];
+    }
+    os << std::endl;
+  }
+}
+
+}  // namespace instrumentation
+
+#ifdef KMEANS_INSTRUMENT
+#define INSTRUMENT_SCOPE(phase) instrumentation::Scope instrument_scope(instrumentation::Phase::phase)
+#define INSTRUMENT_COUNT(counter, amount) instrumentation::count(instrumentation::Counter::counter, amount)
+#define INSTRUMENT_ADOPT(phase) instrumentation::Adopt instrument_adopt(phase)
+#else
+#define INSTRUMENT_SCOPE(phase) ((void)0)
+#define INSTRUMENT_COUNT(counter, amount) ((void)0)
+#define INSTRUMENT_ADOPT(phase) ((void)0)
+#endif
+
+#endif  // INSTRUMENTATION_H
@@ -20,99 +20,665 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <numeric>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <functional>
+#include <chrono>
+#include <type_traits>
 #include "solution.h"
+#include "thread-pool.h"
+#include "nearest-index.h"
+#include "blocked-distance.h"
+#include "seeding.h"
+#include "solver-control.h"
+#include "instrumentation.h"
 
+/**
+ * @brief Strategies of the assignment step. On double points all but
+ *        kBlocked produce exactly the same labels; Hamerly and Elkan skip the
+ *        distances that the triangle inequality proves unnecessary. On float
+ *        points kIndexed compares the distances in double and the others in
+ *        float, so it may also send near ties to another centroid
+ *        kLloyd: every point against every centroid
+ *        kHamerly: one upper and one lower bound per point (O(n) memory)
+ *        kElkan: one lower bound per point and centroid (O(n·k) memory)
+ *        kIndexed: one nearest center query per point on a NearestIndex of
+ *                  the centroids (large k in few dimensions)
+ *        kBlocked: every point against every centroid as a blocked matrix
+ *                  product (large k in many dimensions). Its rounding differs
+ *                  from Lloyd's, so near ties may go to another centroid
+*/
+enum class KMeansAssignment { kLloyd, kHamerly, kElkan, kIndexed, kBlocked };
+
+/**
+ * @brief Why a k-means run stopped
+*/
+enum class KMeansStop { kRunning, kConverged, kSseTolerance, kMaxIterations, kDeadline, kCancelled };
+
+/**
+ * @brief State of a k-means run after one iteration, for telemetry
+*/
+struct KMeansIteration {
+  int iteration;   // Empezando en 1
+  double shift;    // Mayor cambio de una coordenada de un centroide
+  double sse;      // Suma de distancias al cuadrado antes de mover los centroides (NaN si no se calcula)
+  double elapsed;  // Segundos desde el inicio, incluida la inicialización
+  KMeansStop stop; // kRunning salvo en la última iteración
+};
+
+/**
+ * @brief When a k-means run stops. The first condition that holds wins
+*/
+struct KMeansStopping {
+  double shift_tolerance{0.001};     // Ningún centroide se mueve más en ninguna dimensión
+  double sse_tolerance{0};           // Mejora relativa mínima de la SSE (0 = no se comprueba)
+  int max_iterations{0};             // 0 = sin límite
+  std::optional<double> time_limit;  // Segundos de reloj, comprobados al final de cada iteración
+};
+
+/**
+ * @brief Options of the k-means algorithm
+*/
+struct KMeansOptions {
+  int threads{1};  // Hilos del pool, incluido el llamador (0 = todos los del sistema)
+  std::optional<unsigned> seed;  // Semilla fija: mismos resultados con el mismo número de hilos
+  KMeansAssignment assignment{KMeansAssignment::kLloyd};
+  NearestIndexKind index{NearestIndexKind::kAuto};  // Índice de los centroides con kIndexed
+  KMeansInitialization initialization{KMeansInitialization::kRandom};
+  int oversampling_rounds{5};      // Rondas de k-means||
+  double oversampling_factor{2};   // Candidatos por ronda de k-means||, en múltiplos de k
+  KMeansStopping stopping;
+  // Llamado al final de cada iteración; con él también se calcula la SSE
+  std::function<void(const KMeansIteration&)> on_iteration;
+  bool keep_history{false};  // Devolver los centroides de cada iteración, no solo los finales
+  int exact_sums_every{16};  // Iteraciones entre recálculos completos de las sumas (0 = nunca)
+  // Plazo y cancelación, comprobados al final de cada iteración; se publican como mejora
+  // los centroides de cada iteración que baja la SSE y, al parar, los devueltos
+  SolverControl control;
+};
+
+/**
+ * @brief Buffers of one k-means run. They are sized once before the first
+ *        iteration, so the assignment and update steps allocate nothing
+ * @tparam T Precision of the points. Only the point to centroid distances
+ *           use it; sums, bounds and errors are always accumulated in double
+*/
+template <typename T>
+struct LloydWorkspace {
+  LloydWorkspace(int n, int k, int d, int chunks, KMeansAssignment assignment)
+      : chunks(chunks), labels(n, -1), sums(size_t(k) * d, 0), counts(k, 0),
+        delta_sums(size_t(chunks) * k * d, 0), delta_counts(size_t(chunks) * k, 0),
+        touched(size_t(chunks) * k, 0), distances(size_t(chunks) * k), shifts(chunks, 0), errors(chunks, 0),
+        drifts(k, 0) {
+    if (assignment == KMeansAssignment::kLloyd || assignment == KMeansAssignment::kBlocked) return;
+    upper.assign(n, 0);
+    lower.assign(assignment == KMeansAssignment::kElkan ? size_t(n) * k : size_t(n), 0);
+    half_separation.assign(k, 0);
+    if (assignment == KMeansAssignment::kElkan) {
+      centroid_distances.assign(size_t(k) * k, 0);
+    }
+  }
+
+  /**
+   * @brief Moves point i to the cluster `label`, recording the change in the
+   *        delta accumulators of its chunk
+  */
+  void relabel(int chunk, int i, int label, BasicPointSpan<const T> point) {
+    int k = counts.size();
+    int d = point.size();
+    int previous = labels[i];
+    if (previous == label) return;
+    if (previous >= 0) {
+      size_t slot = size_t(chunk) * k + previous;
+      double* sum = delta_sums.data() + slot * d;
+      for (int j{0}; j < d; ++j) {
+        sum[j] -= point[j];
+      }
+      delta_counts[slot]--;
+      touched[slot] = 1;
+    }
+    size_t slot = size_t(chunk) * k + label;
+    double* sum = delta_sums.data() + slot * d;
+    for (int j{0}; j < d; ++j) {
+      sum[j] += point[j];
+    }
+    delta_counts[slot]++;
+    touched[slot] = 1;
+    labels[i] = label;
+  }
+
+  int chunks;
+  std::vector<int> labels;           // Centroide de cada punto (-1 antes de asignarlo)
+  std::vector<double> sums;          // Suma de los puntos de cada centroide
+  std::vector<int> counts;           // Número de puntos de cada centroide
+  std::vector<double> delta_sums;    // Cambios en las sumas hechos por cada trozo
+  std::vector<int> delta_counts;     // Cambios en los contadores hechos por cada trozo
+  std::vector<char> touched;         // Centroides con cambios en cada trozo
+  std::vector<T> distances;          // Distancias de un punto a los centroides, por trozo
+  std::vector<double> shifts;        // Mayor desplazamiento de un centroide, por trozo
+  std::vector<double> errors;        // Suma de distancias al cuadrado, por trozo
+  std::vector<double> drifts;        // Distancia recorrida por cada centroide en la última iteración
+  // Cotas de Hamerly y Elkan
+  std::vector<double> upper;               // Cota superior de la distancia al centroide asignado
+  std::vector<double> lower;               // Cota inferior (al segundo más cercano o a cada centroide)
+  std::vector<double> half_separation;     // Mitad de la distancia al centroide más cercano
+  std::vector<double> centroid_distances;  // Distancias entre centroides (Elkan)
+  BlockedDistances<T> blocked;             // Centroides empaquetados en paneles (kBlocked)
+};
+
+/**
+ * @brief K-means over a Problem or a FloatProblem. With float points the
+ *        distances run on float kernels (twice the SIMD width) against a
+ *        float copy of the centroids, while the centroids, their sums and
+ *        the SSE stay in double
+*/
 class KMeans {
  public:
-  KMeans();
-  std::vector<Solution> solve(const Problem& points, int k);
+  KMeans(const KMeansOptions& options = KMeansOptions());
+  template <typename T>
+  std::vector<Solution> solve(const BasicProblem<T>& points, int k);
+ private:
+  KMeansOptions options_;
+  std::shared_ptr<ThreadPool> pool_;  // Compartido entre las copias del algoritmo
+
+  template <typename T>
+  void assign(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace);
+  template <typename T>
+  void assign_hamerly(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace);
+  template <typename T>
+  void assign_elkan(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace);
+  template <typename T>
+  void assign_indexed(const BasicProblem<T>& points, const std::vector<double>& centroids, int k, LloydWorkspace<T>& workspace, std::unique_ptr<NearestIndex>& index);
+  template <typename T>
+  void assign_blocked(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace);
+  template <typename T>
+  void separate_centroids(const std::vector<T>& centroids, int k, int d, LloydWorkspace<T>& workspace);
+  template <typename T>
+  void resum(const BasicProblem<T>& points, int k, LloydWorkspace<T>& workspace);
+  template <typename T>
+  double update(int k, int d, std::vector<double>& centroids, LloydWorkspace<T>& workspace);
+  template <typename T>
+  double sum_of_squared_errors(const BasicProblem<T>& points, const std::vector<T>& centroids, LloydWorkspace<T>& workspace);
+  Solution to_solution(const std::vector<double>& centroids, int k, int d);
 };
 
-KMeans::KMeans() {}
+/**
+ * @brief True when a is smaller than b beyond the rounding errors of
+ *        distances computed in precision T. Bounds only prune a distance
+ *        when this holds, so ties are always recomputed and broken like
+ *        Lloyd does (lowest centroid index)
+ */
+template <typename T>
+inline bool certainly_less(double a, double b) {
+  return a < b * (1 - (std::is_same<T, float>::value ? 1e-5 : 1e-12));
+}
+
+KMeans::KMeans(const KMeansOptions& options) : options_(options), pool_(std::make_shared<ThreadPool>(options.threads)) {}
 
-std::vector<Solution> KMeans::solve(const Problem& points, int k) {
-  // Seleccionar K puntos aleatorios como centroides iniciales
-  std::set<int> random_centroids;
+/**
+ * @brief Runs k-means until the stopping policy of the options holds
+ * @return Final centroids, preceded by those of every iteration if the
+ *         options keep the history
+ */
+template <typename T>
+std::vector<Solution> KMeans::solve(const BasicProblem<T>& points, int k) {
+  INSTRUMENT_SCOPE(kKMeans);
+  if (k < 1 || k > points.size()) {
+    throw std::invalid_argument("The number of clusters must be between 1 and the number of points");
+  }
+  auto start = std::chrono::steady_clock::now();
+  // Centroides iniciales
   std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<> dis(0, points.size() - 1);
-  while (random_centroids.size() < k) {
-    random_centroids.insert(dis(gen));
+  std::mt19937 gen(options_.seed ? *options_.seed : rd());
+  int d = points.dimensions();
+  std::vector<double> centroids;
+  switch (options_.initialization) {
+    case KMeansInitialization::kPlusPlus:
+      centroids = seed_plus_plus(points, k, gen, *pool_);
+      break;
+    case KMeansInitialization::kParallel:
+      centroids = seed_parallel(points, k, gen, *pool_, options_.oversampling_rounds, options_.oversampling_factor);
+      break;
+    default:
+      centroids = seed_random(points, k, gen);
   }
+  // Copia de los centroides en la precisión de los puntos, para los núcleos de distancia
+  std::vector<T> narrowed;
+  auto in_precision = [&]() -> const std::vector<T>& {
+    if constexpr (std::is_same<T, double>::value) {
+      return centroids;
+    } else {
+      narrowed.assign(centroids.begin(), centroids.end());
+      return narrowed;
+    }
+  };
+  std::vector<Solution> solutions;
+  LloydWorkspace<T> workspace(points.size(), k, d, std::min(points.size(), pool_->size()), options_.assignment);
+  std::unique_ptr<NearestIndex> index;
+  const KMeansStopping& stopping = options_.stopping;
+  const SolverControl& control = options_.control;
+  bool needs_sse = options_.on_iteration || control.on_improvement || stopping.sse_tolerance > 0;
+  double previous_sse{INFINITY};
+  double best_sse{INFINITY};  // Última SSE avisada a control.on_improvement
+  double shift{INFINITY};
+  double last_sse{NAN};  // SSE de la última asignación
+  // Recorremos todos los puntos y centroides para asignar cada punto al centroide más cercano
+  auto assign_step = [&](const std::vector<T>& current) {
+    switch (options_.assignment) {
+      case KMeansAssignment::kHamerly:
+        assign_hamerly(points, current, k, workspace);
+        break;
+      case KMeansAssignment::kElkan:
+        assign_elkan(points, current, k, workspace);
+        break;
+      case KMeansAssignment::kIndexed:
+        assign_indexed(points, centroids, k, workspace, index);
+        break;
+      case KMeansAssignment::kBlocked:
+        assign_blocked(points, current, k, workspace);
+        break;
+      default:
+        assign(points, current, k, workspace);
+    }
+  };
 
-  // Los primeros clusters corresponden con los centroides iniciales
-  Solution solution(points.dimensions());
-  for (auto it: random_centroids) {
-    solution.push_back(points[it]);
+  // Repetir hasta que se cumpla alguna condición de parada
+  for (int iteration{1}; ; ++iteration) {
+    const std::vector<T>& current = in_precision();
+    assign_step(current);
+    double sse = needs_sse ? sum_of_squared_errors(points, current, workspace) : NAN;
+    last_sse = sse;
+    // Se avisa con los centroides que han dado esta SSE, antes de moverlos
+    if (control.on_improvement && sse < best_sse) {
+      best_sse = sse;
+      control.on_improvement(to_solution(centroids, k, d), sse);
+    }
+    // Calcular los nuevos centroides, de vez en cuando con las sumas rehechas desde cero
+    if (options_.exact_sums_every > 0 && iteration % options_.exact_sums_every == 0) {
+      resum(points, k, workspace);
+    }
+    shift = update(k, d, centroids, workspace);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    KMeansStop stop{KMeansStop::kRunning};
+    if (shift <= stopping.shift_tolerance) {
+      stop = KMeansStop::kConverged;
+    } else if (stopping.sse_tolerance > 0 && iteration > 1 &&
+               previous_sse - sse <= stopping.sse_tolerance * previous_sse) {
+      stop = KMeansStop::kSseTolerance;
+    } else if (stopping.max_iterations > 0 && iteration >= stopping.max_iterations) {
+      stop = KMeansStop::kMaxIterations;
+    } else if (stopping.time_limit && elapsed >= *stopping.time_limit) {
+      stop = KMeansStop::kDeadline;
+    } else if (control.cancellation.cancelled()) {
+      stop = KMeansStop::kCancelled;
+    } else if (control.stop_requested()) {
+      stop = KMeansStop::kDeadline;
+    }
+    previous_sse = sse;
+    if (options_.on_iteration) {
+      options_.on_iteration({iteration, shift, sse, elapsed, stop});
+    }
+    if (options_.keep_history || stop != KMeansStop::kRunning) {
+      solutions.push_back(to_solution(centroids, k, d));
+    }
+    if (stop != KMeansStop::kRunning) break;
   }
-  std::vector<Cluster> clusters(k);
-  std::vector<Solution> solutions;
-  Solution new_solution(points.dimensions());
+  // Los centroides devueltos se han movido tras el último aviso: se avisa también de ellos.
+  // Son las medias de la última asignación, así que su SSE sobre ella es la anterior menos
+  // la de cada desplazamiento (teorema de Steiner), sin recorrer otra vez los puntos
+  if (control.on_improvement && shift > 0) {
+    double sse = last_sse;
+    for (int c{0}; c < k; ++c) {
+      sse -= workspace.counts[c] * workspace.drifts[c] * workspace.drifts[c];
+    }
+    if (sse <= best_sse) control.on_improvement(solutions.back(), std::max(0.0, sse));
+  }
+  return solutions;
+}
 
-  // Recorremos todos los puntos y centroides para asignar cada punto al centroide más cercano
-  for (int i{0}; i < points.size(); ++i) {  // Recorrer todos los puntos
-    double min_distance{INFINITY};
-    int closest_centroid_index{0};
-    for (int j{0}; j < k; ++j) {  // Recorrer todos los centroides
-      double distance{euclidean_distance(points[i], solution[j])};
-      if (distance < min_distance) {
-        min_distance = distance;
-        closest_centroid_index = j;
+/**
+ * @brief Labels each point with its closest centroid.
+ *        The points are split in chunks that run on the pool; each point is
+ *        compared against all the row-major centroids with one batched
+ *        kernel call, using squared distances. When a point changes of
+ *        centroid, the chunk records it in its own delta accumulators
+ */
+template <typename T>
+void KMeans::assign(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace) {
+  int d = points.dimensions();
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), workspace.chunks, chunk);
+    T* distances = workspace.distances.data() + size_t(chunk) * k;
+    for (int i{range.first}; i < range.second; ++i) {  // Recorrer los puntos del trozo
+      batch_squared_l2(points[i].data(), centroids.data(), k, d, distances);
+      T min_distance{INFINITY};
+      int closest_centroid_index{0};
+      for (int j{0}; j < k; ++j) {  // Recorrer todos los centroides
+        if (distances[j] < min_distance) {
+          min_distance = distances[j];
+          closest_centroid_index = j;
+        }
       }
+      workspace.relabel(chunk, i, closest_centroid_index, points[i]);  // Asignar el punto al cluster más cercano
     }
-    clusters[closest_centroid_index].push_back(points[i]);  // Asignar el punto al cluster más cercano
-  }
+  });
+}
 
-  // Calcular los nuevos centroides
-  for (int i{0}; i < k; ++i) {  // Recorrer todos los centroides
-    Point centroid;
-    for (int j{0}; j < points.dimensions(); ++j) {  // for each dimension
-      double sum{0};
-      for (int k{0}; k < clusters[i].size(); ++k) {  // for each point in the cluster
-        sum += clusters[i][k][j];
+/**
+ * @brief Computes the distances between centroids (kept only for Elkan) and,
+ *        for each centroid, half the distance to its closest other centroid
+ */
+template <typename T>
+void KMeans::separate_centroids(const std::vector<T>& centroids, int k, int d, LloydWorkspace<T>& workspace) {
+  bool keep_matrix = !workspace.centroid_distances.empty();
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(k, workspace.chunks, chunk);
+    T* distances = workspace.distances.data() + size_t(chunk) * k;
+    for (int c{range.first}; c < range.second; ++c) {
+      batch_squared_l2(centroids.data() + size_t(c) * d, centroids.data(), k, d, distances);
+      double closest{INFINITY};
+      for (int other{0}; other < k; ++other) {
+        double distance = std::sqrt(double(distances[other]));
+        if (keep_matrix) workspace.centroid_distances[size_t(c) * k + other] = distance;
+        if (other != c) closest = std::min(closest, distance);
       }
-      centroid.push_back(sum / clusters[i].size());
+      workspace.half_separation[c] = closest / 2;
     }
-    new_solution.push_back(centroid);
-  }
+  });
+}
 
-  // Repetir. Si los clusters no cambian, terminar
-  while (solution != new_solution) {
-    solutions.push_back(new_solution);
-    solution = new_solution;
-    new_solution = Solution(points.dimensions());
-    for (int i{0}; i < k; ++i) {
-      clusters[i].clear();
-    }
-    // Recorremos todos los puntos y centroides para asignar cada punto al centroide más cercano
-    for (int i{0}; i < points.size(); ++i) {  // Recorrer todos los puntos
-      double min_distance{euclidean_distance(points[i], solution[0])};
+/**
+ * @brief Hamerly's assignment. Each point keeps an upper bound of the
+ *        distance to its centroid and a lower bound of the distance to any
+ *        other; a point is only compared with all the centroids when the
+ *        bounds can not prove that its centroid is still the closest
+ */
+template <typename T>
+void KMeans::assign_hamerly(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace) {
+  int d = points.dimensions();
+  separate_centroids(centroids, k, d, workspace);
+  // Los dos mayores desplazamientos, para rebajar las cotas inferiores
+  int farthest{0};
+  double largest_drift{0};
+  double second_drift{0};
+  for (int c{0}; c < k; ++c) {
+    if (workspace.drifts[c] > largest_drift) {
+      second_drift = largest_drift;
+      largest_drift = workspace.drifts[c];
+      farthest = c;
+    } else if (workspace.drifts[c] > second_drift) {
+      second_drift = workspace.drifts[c];
+    }
+  }
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), workspace.chunks, chunk);
+    T* distances = workspace.distances.data() + size_t(chunk) * k;
+    for (int i{range.first}; i < range.second; ++i) {
+      int label = workspace.labels[i];
+      double& upper = workspace.upper[i];
+      double& lower = workspace.lower[i];
+      if (label >= 0) {
+        upper += workspace.drifts[label];
+        lower -= label == farthest ? second_drift : largest_drift;
+        double bound = std::max(workspace.half_separation[label], lower);
+        if (certainly_less<T>(upper, bound)) continue;
+        // Se ajusta la cota superior antes de recorrer todos los centroides
+        upper = std::sqrt(double(squared_l2(points[i].data(), centroids.data() + size_t(label) * d, d)));
+        if (certainly_less<T>(upper, bound)) continue;
+      }
+      batch_squared_l2(points[i].data(), centroids.data(), k, d, distances);
+      T min_distance{INFINITY};
+      T second_distance{INFINITY};
       int closest_centroid_index{0};
-      for (int j{0}; j < k; ++j) {  // Recorrer todos los centroides
-        double distance{euclidean_distance(points[i], solution[j])};
-        if (distance < min_distance) {
-          min_distance = distance;
+      for (int j{0}; j < k; ++j) {
+        if (distances[j] < min_distance) {
+          second_distance = min_distance;
+          min_distance = distances[j];
           closest_centroid_index = j;
+        } else if (distances[j] < second_distance) {
+          second_distance = distances[j];
         }
       }
-      clusters[closest_centroid_index].push_back(points[i]);  // Asignar el punto al cluster más cercano
+      upper = std::sqrt(double(min_distance));
+      lower = std::sqrt(double(second_distance));
+      workspace.relabel(chunk, i, closest_centroid_index, points[i]);
     }
+  });
+}
 
-    // Calcular los nuevos centroides
-    for (int i{0}; i < k; ++i) {  // Recorrer todos los centroides
-      Point centroid;
-      for (int j{0}; j < points.dimensions(); ++j) {  // for each dimension
-        double sum{0};
-        for (int k{0}; k < clusters[i].size(); ++k) {  // for each point in the cluster
-          sum += clusters[i][k][j];
+/**
+ * @brief Elkan's assignment. Each point keeps an upper bound of the distance
+ *        to its centroid and a lower bound of the distance to every centroid;
+ *        together with the distances between centroids they skip most of the
+ *        point-centroid distances
+ */
+template <typename T>
+void KMeans::assign_elkan(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace) {
+  int d = points.dimensions();
+  separate_centroids(centroids, k, d, workspace);
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), workspace.chunks, chunk);
+    T* distances = workspace.distances.data() + size_t(chunk) * k;
+    for (int i{range.first}; i < range.second; ++i) {
+      int label = workspace.labels[i];
+      double& upper = workspace.upper[i];
+      double* lower = workspace.lower.data() + size_t(i) * k;
+      const T* point = points[i].data();
+      if (label < 0) {  // Primera asignación: todas las distancias
+        batch_squared_l2(point, centroids.data(), k, d, distances);
+        T min_distance{INFINITY};
+        int closest_centroid_index{0};
+        for (int j{0}; j < k; ++j) {
+          lower[j] = std::sqrt(double(distances[j]));
+          if (distances[j] < min_distance) {
+            min_distance = distances[j];
+            closest_centroid_index = j;
+          }
         }
-        centroid.push_back(sum / clusters[i].size());
+        upper = std::sqrt(double(min_distance));
+        workspace.relabel(chunk, i, closest_centroid_index, points[i]);
+        continue;
+      }
+      upper += workspace.drifts[label];
+      for (int j{0}; j < k; ++j) {
+        lower[j] = std::max(0.0, lower[j] - workspace.drifts[j]);
       }
-      new_solution.push_back(centroid);
+      if (certainly_less<T>(upper, workspace.half_separation[label])) continue;
+      bool tight{false};
+      int closest = label;
+      T closest_squared{0};  // Distancia al cuadrado al más cercano, válida con tight
+      for (int j{0}; j < k; ++j) {
+        if (j == closest) continue;
+        double half_gap = workspace.centroid_distances[size_t(closest) * k + j] / 2;
+        if (certainly_less<T>(upper, lower[j]) || certainly_less<T>(upper, half_gap)) continue;
+        if (!tight) {
+          closest_squared = squared_l2(point, centroids.data() + size_t(closest) * d, d);
+          upper = std::sqrt(double(closest_squared));
+          lower[closest] = upper;
+          tight = true;
+          if (certainly_less<T>(upper, lower[j]) || certainly_less<T>(upper, half_gap)) continue;
+        }
+        T squared = squared_l2(point, centroids.data() + size_t(j) * d, d);
+        double distance = std::sqrt(double(squared));
+        lower[j] = distance;
+        // Se comparan los cuadrados, como en Lloyd: dos distintos pueden tener la misma raíz.
+        // En caso de empate gana el índice menor
+        if (squared < closest_squared || (squared == closest_squared && j < closest)) {
+          closest = j;
+          closest_squared = squared;
+          upper = distance;
+        }
+      }
+      workspace.relabel(chunk, i, closest, points[i]);
+    }
+  });
+}
+
+/**
+ * @brief Labels each point with a query to a nearest center index of the
+ *        centroids. The index is built on the first iteration; later only
+ *        the centroids that moved are updated in it. The index works in
+ *        double, so float points are widened one at a time
+ */
+template <typename T>
+void KMeans::assign_indexed(const BasicProblem<T>& points, const std::vector<double>& centroids, int k, LloydWorkspace<T>& workspace, std::unique_ptr<NearestIndex>& index) {
+  int d = points.dimensions();
+  if (!index) {
+    index = make_nearest_index(options_.index, k, d);
+    index->build(centroids.data(), k, d);
+  } else {
+    for (int c{0}; c < k; ++c) {
+      if (workspace.drifts[c] > 0) index->update(c, centroids.data() + size_t(c) * d);
     }
   }
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), workspace.chunks, chunk);
+    std::vector<double> widened(std::is_same<T, double>::value ? 0 : d);
+    for (int i{range.first}; i < range.second; ++i) {
+      const double* query;
+      if constexpr (std::is_same<T, double>::value) {
+        query = points[i].data();
+      } else {
+        std::copy(points[i].begin(), points[i].end(), widened.begin());
+        query = widened.data();
+      }
+      workspace.relabel(chunk, i, index->nearest(query).first, points[i]);
+    }
+  });
+}
 
-  return solutions;
+/**
+ * @brief Labels each point with its closest centroid, taking the distances
+ *        of a block of points to all the centroids as one matrix product
+ *        fused with the argmin. The centroids are packed once per iteration;
+ *        the point norms come from the problem if it has them cached
+ */
+template <typename T>
+void KMeans::assign_blocked(const BasicProblem<T>& points, const std::vector<T>& centroids, int k, LloydWorkspace<T>& workspace) {
+  int d = points.dimensions();
+  workspace.blocked.set_centers(centroids.data(), k, d);
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), workspace.chunks, chunk);
+    int labels[blocked::kBlockRows];
+    T distances[blocked::kBlockRows];
+    for (int start{range.first}; start < range.second; start += blocked::kBlockRows) {
+      int end = std::min(range.second, start + blocked::kBlockRows);
+      workspace.blocked.nearest(points.data(), points.norms(), start, end, labels, distances);
+      for (int i{start}; i < end; ++i) {
+        workspace.relabel(chunk, i, labels[i - start], points[i]);
+      }
+    }
+  });
+}
+
+/**
+ * @brief Applies the deltas of every chunk to the running sums and counts
+ *        and moves the centroids that changed to the mean of their points.
+ *        The deltas are reduced always in chunk order, so for a fixed
+ *        number of threads the centroids are bit-reproducible. A centroid
+ *        without points keeps its previous position
+ * @return Largest change of a centroid coordinate
+ */
+template <typename T>
+double KMeans::update(int k, int d, std::vector<double>& centroids, LloydWorkspace<T>& workspace) {
+  int chunks = workspace.chunks;
+  pool_->parallel_for(chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(k, chunks, chunk);
+    double shift{0};
+    for (int c{range.first}; c < range.second; ++c) {  // Recorrer los centroides del trozo
+      bool changed{false};
+      double* sum = workspace.sums.data() + size_t(c) * d;
+      workspace.drifts[c] = 0;
+      for (int t{0}; t < chunks; ++t) {
+        size_t slot = size_t(t) * k + c;
+        if (!workspace.touched[slot]) continue;
+        double* delta = workspace.delta_sums.data() + slot * d;
+        for (int j{0}; j < d; ++j) {  // for each dimension
+          sum[j] += delta[j];
+          delta[j] = 0;
+        }
+        workspace.counts[c] += workspace.delta_counts[slot];
+        workspace.delta_counts[slot] = 0;
+        workspace.touched[slot] = 0;
+        changed = true;
+      }
+      if (!changed || workspace.counts[c] == 0) continue;
+      double* centroid = centroids.data() + size_t(c) * d;
+      double drift{0};
+      for (int j{0}; j < d; ++j) {
+        double coordinate = sum[j] / workspace.counts[c];
+        double difference = coordinate - centroid[j];
+        shift = std::max(shift, std::fabs(difference));
+        drift += difference * difference;
+        centroid[j] = coordinate;
+      }
+      workspace.drifts[c] = std::sqrt(drift);
+    }
+    workspace.shifts[chunk] = shift;
+  });
+  if (workspace.shifts.empty()) return 0;
+  return *std::max_element(workspace.shifts.begin(), workspace.shifts.end());
+}
+
+/**
+ * @brief Recomputes the sum and the count of every centroid from the labels,
+ *        dropping the rounding error that the deltas of every iteration
+ *        pile up. Each chunk adds its points to its own delta accumulators,
+ *        and update() adds those to the cleared sums as usual
+ */
+template <typename T>
+void KMeans::resum(const BasicProblem<T>& points, int k, LloydWorkspace<T>& workspace) {
+  int d = points.dimensions();
+  std::fill(workspace.sums.begin(), workspace.sums.end(), 0);
+  std::fill(workspace.counts.begin(), workspace.counts.end(), 0);
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), workspace.chunks, chunk);
+    size_t first = size_t(chunk) * k;
+    double* delta_sums = workspace.delta_sums.data() + first * d;
+    std::fill(delta_sums, delta_sums + size_t(k) * d, 0);
+    std::fill(workspace.delta_counts.begin() + first, workspace.delta_counts.begin() + first + k, 0);
+    // Todos los centroides se recalculan desde sus nuevas sumas
+    std::fill(workspace.touched.begin() + first, workspace.touched.begin() + first + k, 1);
+    for (int i{range.first}; i < range.second; ++i) {
+      int label = workspace.labels[i];
+      if (label < 0) continue;
+      double* sum = delta_sums + size_t(label) * d;
+      BasicPointSpan<const T> point = points[i];
+      for (int j{0}; j < d; ++j) {
+        sum[j] += point[j];
+      }
+      workspace.delta_counts[first + label]++;
+    }
+  });
+}
+
+/**
+ * @brief Sum of the squared distances of the points to their centroids,
+ *        reduced in chunk order
+ */
+template <typename T>
+double KMeans::sum_of_squared_errors(const BasicProblem<T>& points, const std::vector<T>& centroids, LloydWorkspace<T>& workspace) {
+  int d = points.dimensions();
+  pool_->parallel_for(workspace.chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), workspace.chunks, chunk);
+    double error{0};
+    for (int i{range.first}; i < range.second; ++i) {
+      error += squared_l2(points[i].data(), centroids.data() + size_t(workspace.labels[i]) * d, d);
+    }
+    workspace.errors[chunk] = error;
+  });
+  return std::accumulate(workspace.errors.begin(), workspace.errors.end(), 0.0);
+}
+
+Solution KMeans::to_solution(const std::vector<double>& centroids, int k, int d) {
+  Solution solution(d);
+  for (int c{0}; c < k; ++c) {
+    solution.push_back(ConstPointSpan(centroids.data() + size_t(c) * d, d));
+  }
+  return solution;
 }
 
 #endif  // K_MEANS_H
\ No newline at end of file
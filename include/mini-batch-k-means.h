@@ -0,0 +1,188 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file mini-batch-k-means.h
+ * @brief MiniBatchKMeans class
+ *        This class implements the mini-batch k-means algorithm over a
+ *        stream of points
+ */
+
+#ifndef MINI_BATCH_K_MEANS_H
+#define MINI_BATCH_K_MEANS_H
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include "solution.h"
+#include "point-stream.h"
+#include "thread-pool.h"
+
+/**
+ * @brief Options of the mini-batch k-means algorithm
+*/
+struct MiniBatchKMeansOptions {
+  int batch_size{1024};          // Puntos leídos y procesados en cada lote
+  int epochs{1};                 // Pasadas completas sobre la instancia
+  int checkpoint_every{0};       // Guardar los centroides cada N lotes (0 = nunca)
+  std::string checkpoint_path;   // Fichero de los centroides guardados
+  int threads{1};                // Hilos para la asignación de cada lote (0 = todos)
+  std::optional<unsigned> seed;  // Semilla fija para resultados reproducibles
+};
+
+class MiniBatchKMeans {
+ public:
+  MiniBatchKMeans(const MiniBatchKMeansOptions& options = MiniBatchKMeansOptions());
+  std::vector<Solution> solve(PointStream& stream, int k);
+  double evaluate(PointStream& stream, const Solution& solution);
+ private:
+  MiniBatchKMeansOptions options_;
+  std::shared_ptr<ThreadPool> pool_;
+
+  void assign(const Problem& batch, const std::vector<double>& centroids, int k, std::vector<int>& labels);
+  void checkpoint(const std::vector<double>& centroids, int k, int d);
+};
+
+MiniBatchKMeans::MiniBatchKMeans(const MiniBatchKMeansOptions& options)
+    : options_(options), pool_(std::make_shared<ThreadPool>(options.threads)) {}
+
+/**
+ * @brief Clusters the points of the stream reading them one batch at a time.
+ *        The initial centroids are a uniform sample (reservoir sampling) of
+ *        k of the first max(batch_size, k) points, read in batches straight
+ *        into the centroids, so no more than one batch is held besides them.
+ *        Each point of a batch then pulls its closest centroid towards
+ *        itself with a learning rate of 1 / (points seen by that centroid)
+ * @return Centroids at the end of each epoch
+ */
+std::vector<Solution> MiniBatchKMeans::solve(PointStream& stream, int k) {
+  int d = stream.dimensions();
+  if (stream.size() < k) {
+    throw std::invalid_argument("The instance has fewer points than clusters");
+  }
+  Problem batch(0, d);
+  std::vector<int> labels;
+  std::vector<double> centroids(size_t(k) * d);
+  std::vector<long> counts(k, 0);
+  std::vector<Solution> solutions;
+
+  // Muestreo de K puntos aleatorios entre los primeros (algoritmo R)
+  std::random_device rd;
+  std::mt19937 gen(options_.seed ? *options_.seed : rd());
+  int sampled = std::max(options_.batch_size, k);
+  int seen{0};
+  stream.rewind();
+  while (seen < sampled) {
+    int count = stream.next_batch(batch, std::min(options_.batch_size, sampled - seen));
+    if (count == 0) break;
+    for (int i{0}; i < count; ++i, ++seen) {
+      int slot = seen;
+      if (seen >= k) {
+        slot = std::uniform_int_distribution<>(0, seen)(gen);
+        if (slot >= k) continue;
+      }
+      std::copy(batch[i].begin(), batch[i].end(), centroids.begin() + size_t(slot) * d);
+    }
+  }
+
+  long batches{0};
+  int count{0};
+  for (int epoch{0}; epoch < options_.epochs; ++epoch) {
+    stream.rewind();
+    count = stream.next_batch(batch, options_.batch_size);
+    while (count > 0) {
+      labels.resize(count);
+      assign(batch, centroids, k, labels);
+      // Actualización en el orden de los puntos: el resultado no depende de los hilos
+      for (int i{0}; i < count; ++i) {
+        double* closest = centroids.data() + size_t(labels[i]) * d;
+        double learning_rate = 1.0 / ++counts[labels[i]];
+        ConstPointSpan point = batch[i];
+        for (int j{0}; j < d; ++j) {
+          closest[j] += learning_rate * (point[j] - closest[j]);
+        }
+      }
+      ++batches;
+      if (options_.checkpoint_every > 0 && batches % options_.checkpoint_every == 0) {
+        checkpoint(centroids, k, d);
+      }
+      count = stream.next_batch(batch, options_.batch_size);
+    }
+    Solution solution(d);
+    for (int c{0}; c < k; ++c) {
+      solution.push_back(ConstPointSpan(centroids.data() + size_t(c) * d, d));
+    }
+    solutions.push_back(solution);
+  }
+  if (options_.checkpoint_every > 0) {
+    checkpoint(centroids, k, d);
+  }
+  return solutions;
+}
+
+/**
+ * @brief Same objective as Solution::evaluate, computed one batch at a time
+ */
+double MiniBatchKMeans::evaluate(PointStream& stream, const Solution& solution) {
+  Problem batch(0, stream.dimensions());
+  double sum_of_distances{0};
+  stream.rewind();
+  while (stream.next_batch(batch, options_.batch_size) > 0) {
+    sum_of_distances += solution.evaluate(batch) - solution.penalty();
+  }
+  return sum_of_distances + solution.penalty();
+}
+
+/**
+ * @brief Labels each point of the batch with its closest centroid, in chunks
+ *        that run on the pool
+ */
+void MiniBatchKMeans::assign(const Problem& batch, const std::vector<double>& centroids, int k, std::vector<int>& labels) {
+  int d = batch.dimensions();
+  int chunks = std::min(batch.size(), pool_->size());
+  pool_->parallel_for(chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(batch.size(), chunks, chunk);
+    std::vector<double> distances(k);
+    for (int i{range.first}; i < range.second; ++i) {
+      batch_squared_l2(batch[i].data(), centroids.data(), k, d, distances.data());
+      labels[i] = std::min_element(distances.begin(), distances.end()) - distances.begin();
+    }
+  });
+}
+
+/**
+ * @brief Writes the centroids in the instance format, so the checkpoint can
+ *        be loaded as a problem. The file is replaced atomically
+ */
+void MiniBatchKMeans::checkpoint(const std::vector<double>& centroids, int k, int d) {
+  if (options_.checkpoint_path.empty()) return;
+  std::string temporary = options_.checkpoint_path + ".tmp";
+  {
+    std::ofstream file(temporary);
+    file.precision(17);
+    file << k << "\n" << d << "\n";
+    for (int c{0}; c < k; ++c) {
+      for (int j{0}; j < d; ++j) {
+        file << centroids[size_t(c) * d + j] << (j + 1 < d ? " " : "\n");
+      }
+    }
+    if (!file) {
+      throw std::runtime_error("Error writing checkpoint " + temporary);
+    }
+  }
+  if (std::rename(temporary.c_str(), options_.checkpoint_path.c_str()) != 0) {
+    throw std::runtime_error("Error replacing checkpoint " + options_.checkpoint_path);
+  }
+}
+
+#endif  // MINI_BATCH_K_MEANS_H
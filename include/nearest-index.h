@@ -0,0 +1,372 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file nearest-index.h
+ * @brief NearestIndex classes
+ *        This file contains the indexes that find the nearest and second
+ *        nearest center of a point: brute force, k-d tree and ball tree
+ */
+
+#ifndef NEAREST_INDEX_H
+#define NEAREST_INDEX_H
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "distance.h"
+
+/**
+ * @brief Kinds of nearest center index
+ *        kAuto: brute force for few centers, k-d tree for low dimensions and
+ *               ball tree for medium ones
+ *        kBruteForce: every center
+ *        kKdTree: axis-aligned splits, best up to ~10 dimensions
+ *        kBallTree: nested balls, degrades slower with the dimension
+*/
+enum class NearestIndexKind { kAuto, kBruteForce, kKdTree, kBallTree };
+
+/**
+ * @brief Nearest and second nearest center of a point, with their squared
+ *        distances. Ties go to the lowest center index, like a linear scan
+*/
+struct Neighbors {
+  int first{-1};
+  double first_distance{INFINITY};
+  int second{-1};
+  double second_distance{INFINITY};
+
+  void consider(int center, double distance) {
+    if (distance < first_distance || (distance == first_distance && center < first)) {
+      second = first;
+      second_distance = first_distance;
+      first = center;
+      first_distance = distance;
+    } else if (distance < second_distance || (distance == second_distance && center < second)) {
+      second = center;
+      second_distance = distance;
+    }
+  }
+};
+
+/**
+ * @brief Exact nearest center queries over k centers of d dimensions. The
+ *        index keeps its own copy of the centers. A moved center is taken
+ *        out of the tree and kept in a small list that every query scans;
+ *        the tree is rebuilt when that list grows. Queries are const and can
+ *        run from several threads at once
+*/
+class NearestIndex {
+ public:
+  virtual ~NearestIndex() {}
+
+  /**
+   * @brief Indexes k row-major centers
+  */
+  void build(const double* centers, int k, int d) {
+    centers_.assign(centers, centers + size_t(k) * d);
+    k_ = k;
+    d_ = d;
+    moved_.assign(k, 0);
+    overflow_.clear();
+    rebuild();
+  }
+
+  /**
+   * @brief Indexes the centers of a solution (size() and operator[])
+  */
+  template <typename Centers>
+  void build(const Centers& centers, int d) {
+    packed_.clear();
+    for (int c{0}; c < centers.size(); ++c) {
+      packed_.insert(packed_.end(), centers[c].begin(), centers[c].end());
+    }
+    build(packed_.data(), centers.size(), d);
+  }
+
+  /**
+   * @brief Moves center c to a new position
+  */
+  virtual void update(int c, const double* center) {
+    std::copy(center, center + d_, centers_.begin() + size_t(c) * d_);
+    if (!moved_[c]) {
+      moved_[c] = 1;
+      overflow_.push_back(c);
+    }
+    if (overflow_.size() > std::max<size_t>(8, k_ / 16)) {
+      std::fill(moved_.begin(), moved_.end(), 0);
+      overflow_.clear();
+      rebuild();
+    }
+  }
+
+  /**
+   * @brief Nearest and second nearest center of x
+  */
+  Neighbors nearest(const double* x) const {
+    Neighbors neighbors;
+    search(x, neighbors);
+    for (int c: overflow_) {
+      neighbors.consider(c, squared_l2(x, center(c), d_));
+    }
+    return neighbors;
+  }
+
+  const int size() const {
+    return k_;
+  }
+
+ protected:
+  std::vector<double> centers_;
+  int k_{0};
+  int d_{0};
+  std::vector<char> moved_;   // Centros que ya no están en su sitio del árbol
+  std::vector<int> overflow_;
+  std::vector<double> packed_;  // Centros de una solución, reutilizado entre construcciones
+
+  const double* center(int c) const {
+    return centers_.data() + size_t(c) * d_;
+  }
+
+  /**
+   * @brief Prunes a region only if its bound is beyond the second nearest
+   *        by more than rounding errors, so ties are always compared
+  */
+  static bool beyond(double bound, double distance) {
+    return bound > distance * (1 + 1e-9);
+  }
+
+  /**
+   * @brief Sorts centers[begin, end) by the coordinate of largest spread and
+   *        returns that dimension
+  */
+  int split_widest(std::vector<int>& order, int begin, int end) const {
+    int widest{0};
+    double largest_spread{-1};
+    for (int j{0}; j < d_; ++j) {
+      double low{INFINITY};
+      double high{-INFINITY};
+      for (int t{begin}; t < end; ++t) {
+        low = std::min(low, center(order[t])[j]);
+        high = std::max(high, center(order[t])[j]);
+      }
+      if (high - low > largest_spread) {
+        largest_spread = high - low;
+        widest = j;
+      }
+    }
+    int middle = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](int a, int b) {
+      return center(a)[widest] < center(b)[widest];
+    });
+    return widest;
+  }
+
+  virtual void rebuild() = 0;
+  virtual void search(const double* x, Neighbors& neighbors) const = 0;
+};
+
+/**
+ * @brief Compares the point with every center
+*/
+class BruteForceIndex : public NearestIndex {
+ public:
+  void update(int c, const double* center) override {
+    std::copy(center, center + d_, centers_.begin() + size_t(c) * d_);
+  }
+
+ protected:
+  void rebuild() override {}
+
+  void search(const double* x, Neighbors& neighbors) const override {
+    for (int c{0}; c < k_; ++c) {
+      neighbors.consider(c, squared_l2(x, center(c), d_));
+    }
+  }
+};
+
+/**
+ * @brief k-d tree: every node splits its centers at the median of the
+ *        coordinate with the largest spread
+*/
+class KdTreeIndex : public NearestIndex {
+ protected:
+  struct Node {
+    int begin, end;        // Centros del nodo en order_
+    int left{-1}, right{-1};
+    int dimension{0};
+    double split{0};
+  };
+
+  std::vector<Node> nodes_;
+  std::vector<int> order_;
+
+  void rebuild() override {
+    nodes_.clear();
+    order_.resize(k_);
+    std::iota(order_.begin(), order_.end(), 0);
+    if (k_ > 0) build_node(0, k_);
+  }
+
+  int build_node(int begin, int end) {
+    int node = nodes_.size();
+    nodes_.push_back({begin, end});
+    if (end - begin <= kLeafSize) return node;
+    int dimension = split_widest(order_, begin, end);
+    int middle = (begin + end) / 2;
+    nodes_[node].dimension = dimension;
+    nodes_[node].split = center(order_[middle])[dimension];
+    int left = build_node(begin, middle);
+    int right = build_node(middle, end);
+    nodes_[node].left = left;
+    nodes_[node].right = right;
+    return node;
+  }
+
+  void search(const double* x, Neighbors& neighbors) const override {
+    if (!nodes_.empty()) search_node(0, x, neighbors);
+  }
+
+  void search_node(int index, const double* x, Neighbors& neighbors) const {
+    const Node& node = nodes_[index];
+    if (node.left < 0) {
+      for (int t{node.begin}; t < node.end; ++t) {
+        int c = order_[t];
+        if (!moved_[c]) neighbors.consider(c, squared_l2(x, center(c), d_));
+      }
+      return;
+    }
+    double difference = x[node.dimension] - node.split;
+    int near = difference < 0 ? node.left : node.right;
+    int far = difference < 0 ? node.right : node.left;
+    search_node(near, x, neighbors);
+    if (!beyond(difference * difference, neighbors.second_distance)) {
+      search_node(far, x, neighbors);
+    }
+  }
+
+ private:
+  static const int kLeafSize = 8;
+};
+
+/**
+ * @brief Ball tree: every node is a ball around the mean of its centers;
+ *        the children split the centers like the k-d tree does
+*/
+class BallTreeIndex : public NearestIndex {
+ protected:
+  struct Node {
+    int begin, end;
+    int left{-1}, right{-1};
+    double radius{0};
+  };
+
+  std::vector<Node> nodes_;
+  std::vector<double> pivots_;  // Centro de la bola de cada nodo
+  std::vector<int> order_;
+
+  void rebuild() override {
+    nodes_.clear();
+    pivots_.clear();
+    order_.resize(k_);
+    std::iota(order_.begin(), order_.end(), 0);
+    if (k_ > 0) build_node(0, k_);
+  }
+
+  int build_node(int begin, int end) {
+    int node = nodes_.size();
+    nodes_.push_back({begin, end});
+    pivots_.resize(pivots_.size() + d_, 0);
+    double* pivot = pivots_.data() + size_t(node) * d_;
+    for (int t{begin}; t < end; ++t) {
+      for (int j{0}; j < d_; ++j) {
+        pivot[j] += center(order_[t])[j] / (end - begin);
+      }
+    }
+    double radius{0};
+    for (int t{begin}; t < end; ++t) {
+      radius = std::max(radius, l2(pivot, center(order_[t]), d_));
+    }
+    nodes_[node].radius = radius;
+    if (end - begin <= kLeafSize) return node;
+    split_widest(order_, begin, end);
+    int middle = (begin + end) / 2;
+    int left = build_node(begin, middle);
+    int right = build_node(middle, end);
+    nodes_[node].left = left;
+    nodes_[node].right = right;
+    return node;
+  }
+
+  /**
+   * @brief Squared lower bound of the distance from x to the ball of node,
+   *        loosened by the rounding error of the subtraction
+  */
+  double bound(int node, const double* x) const {
+    double distance = l2(x, pivots_.data() + size_t(node) * d_, d_);
+    double radius = nodes_[node].radius;
+    double gap = std::max(0.0, distance - radius - 1e-12 * (distance + radius));
+    return gap * gap;
+  }
+
+  void search(const double* x, Neighbors& neighbors) const override {
+    if (!nodes_.empty()) search_node(0, bound(0, x), x, neighbors);
+  }
+
+  void search_node(int index, double node_bound, const double* x, Neighbors& neighbors) const {
+    if (beyond(node_bound, neighbors.second_distance)) return;
+    const Node& node = nodes_[index];
+    if (node.left < 0) {
+      for (int t{node.begin}; t < node.end; ++t) {
+        int c = order_[t];
+        if (!moved_[c]) neighbors.consider(c, squared_l2(x, center(c), d_));
+      }
+      return;
+    }
+    double left_bound = bound(node.left, x);
+    double right_bound = bound(node.right, x);
+    if (left_bound <= right_bound) {
+      search_node(node.left, left_bound, x, neighbors);
+      search_node(node.right, right_bound, x, neighbors);
+    } else {
+      search_node(node.right, right_bound, x, neighbors);
+      search_node(node.left, left_bound, x, neighbors);
+    }
+  }
+
+ private:
+  static const int kLeafSize = 8;
+};
+
+/**
+ * @brief Kind of index that kAuto stands for with k centers of d dimensions
+*/
+inline NearestIndexKind resolve_nearest_index(NearestIndexKind kind, int k, int d) {
+  if (kind != NearestIndexKind::kAuto) return kind;
+  if (k < 64 || d > 32) return NearestIndexKind::kBruteForce;
+  return d <= 10 ? NearestIndexKind::kKdTree : NearestIndexKind::kBallTree;
+}
+
+/**
+ * @brief Creates an empty index of the given kind
+ * @param k Number of centers it will hold (used by kAuto)
+ * @param d Number of dimensions (used by kAuto)
+*/
+inline std::unique_ptr<NearestIndex> make_nearest_index(NearestIndexKind kind, int k, int d) {
+  switch (resolve_nearest_index(kind, k, d)) {
+    case NearestIndexKind::kKdTree:
+      return std::make_unique<KdTreeIndex>();
+    case NearestIndexKind::kBallTree:
+      return std::make_unique<BallTreeIndex>();
+    default:
+      return std::make_unique<BruteForceIndex>();
+  }
+}
+
+#endif  // NEAREST_INDEX_H
@@ -0,0 +1,144 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file point-stream.h
+ * @brief PointStream class
+ *        This class reads an instance file in batches of points
+ */
+
+#ifndef POINT_STREAM_H
+#define POINT_STREAM_H
+
+#include <fstream>
+#include <string>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <unistd.h>
+#include "problem.h"
+#include "instance-io.h"
+
+/**
+ * @brief Sequential reader of an instance in the text format of examples/
+ *        (number of points, number of dimensions and one point per line) or
+ *        in the binary format. A binary instance is mapped and the pages of
+ *        the batches already read are released, so in both formats only one
+ *        batch of points is in memory at a time
+*/
+class PointStream {
+ public:
+  /**
+   * @brief Opens an instance and reads its header
+   * @param path Instance file
+  */
+  PointStream(const std::string& path) : path_(path) {
+    if (is_binary_instance(path)) {
+      mapping_.emplace(path);
+      header_ = read_binary_header(mapping_->data(), mapping_->size(), path);
+      madvise(mapping_->data(), mapping_->size(), MADV_SEQUENTIAL);
+    } else {
+      file_.open(path);
+      if (!file_.is_open()) {
+        throw std::runtime_error("Error opening file " + path);
+      }
+    }
+    read_header();
+  }
+
+  /**
+   * @brief Number of points of the instance
+  */
+  const int size() const {
+    return size_;
+  }
+
+  const int dimensions() const {
+    return dimensions_;
+  }
+
+  /**
+   * @brief Reads the next points into batch, reusing its buffer
+   * @param batch Problem with dimensions() dimensions that receives the points
+   * @param batch_size Maximum number of points to read
+   * @return Number of points read (0 at the end of the instance)
+  */
+  int next_batch(Problem& batch, int batch_size) {
+    int count = std::min(batch_size, size_ - read_);
+    batch.resize(count);
+    if (mapping_) {
+      read_binary(batch, count);
+      read_ += count;
+      return count;
+    }
+    for (int i{0}; i < count; ++i) {
+      PointSpan point = batch[i];
+      for (int j{0}; j < dimensions_; ++j) {
+        if (!(file_ >> point[j])) {
+          throw std::runtime_error("Unexpected end of file " + path_);
+        }
+      }
+    }
+    read_ += count;
+    return count;
+  }
+
+  /**
+   * @brief Goes back to the first point, for another pass over the instance
+  */
+  void rewind() {
+    if (!mapping_) {
+      file_.clear();
+      file_.seekg(0);
+    }
+    read_header();
+  }
+
+ private:
+  std::string path_;
+  std::ifstream file_;
+  std::optional<MappedFile> mapping_;  // Instancia binaria
+  BinaryInstanceHeader header_{};
+  int size_{0};
+  int dimensions_{0};
+  int read_{0};
+
+  void read_header() {
+    read_ = 0;
+    if (mapping_) {
+      size_ = header_.points;
+      dimensions_ = header_.dimensions;
+      return;
+    }
+    if (!(file_ >> size_ >> dimensions_)) {
+      throw std::runtime_error("Invalid header in " + path_);
+    }
+  }
+
+  /**
+   * @brief Copies the next count points of the mapping into batch and
+   *        releases the whole pages before them
+  */
+  void read_binary(Problem& batch, int count) {
+    size_t value_size = header_.dtype == kFloat32 ? sizeof(float) : sizeof(double);
+    size_t begin = header_.data_offset + size_t(read_) * dimensions_ * value_size;
+    size_t values = size_t(count) * dimensions_;
+    const char* data = mapping_->data() + begin;
+    if (header_.dtype == kFloat32) {
+      const float* source = reinterpret_cast<const float*>(data);
+      std::copy(source, source + values, batch.data());
+    } else {
+      const double* source = reinterpret_cast<const double*>(data);
+      std::copy(source, source + values, batch.data());
+    }
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t consumed = (begin + values * value_size) / page * page;
+    if (consumed > 0) madvise(mapping_->data(), consumed, MADV_DONTNEED);
+  }
+};
+
+#endif  // POINT_STREAM_H
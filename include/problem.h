@@ -16,41 +16,150 @@
 
 #include <vector>
 #include <cmath>
+#include <utility>
+#include <algorithm>
+#include "storage.h"
 #include "utilities.h"
 
 /**
  * @brief Defines the clustering problem (localization problem) 
+ *        The points are stored row-major in a single aligned buffer, so
+ *        operator[] returns a non-owning span instead of a Point
+ * @tparam T Scalar type of the coordinates. Problem (double) is the one the
+ *           whole program uses; FloatProblem halves the memory and the
+ *           bandwidth of k-means, which accumulates in double anyway
 */
-class Problem {
+template <typename T>
+class BasicProblem {
  public:
   /**
    * @brief Creates a new problem
    * @param n Number of points
    * @param d Number of dimensions
   */
-  Problem(int n, int d) {
-    for (int i{0}; i < n; ++i) {
-      points_.push_back(Point(d));
-    }
+  BasicProblem(int n, int d) : size_(n), dimensions_(d), points_(size_t(n) * d) {}
+
+  /**
+   * @brief Creates a problem over existing row-major coordinates, without
+   *        copying them (e.g. a memory-mapped instance)
+   * @param n Number of points
+   * @param d Number of dimensions
+   * @param points Buffer with at least n * d coordinates
+  */
+  BasicProblem(int n, int d, AlignedBuffer<T> points) : size_(n), dimensions_(d), points_(std::move(points)) {}
+
+  /**
+   * @brief Copies a problem of another precision, rounding the coordinates
+  */
+  template <typename U>
+  explicit BasicProblem(const BasicProblem<U>& other)
+      : size_(other.size()), dimensions_(other.dimensions()), points_(size_t(other.size()) * other.dimensions()) {
+    std::copy(other.data(), other.data() + size_t(size_) * dimensions_, points_.data());
   }
 
-  const Point& operator[](int i) const {
-    return points_[i];
+  BasicPointSpan<const T> operator[](int i) const {
+    return BasicPointSpan<const T>(points_.data() + size_t(i) * dimensions_, dimensions_);
   }
 
-  Point& operator[](int i) {
-    return points_[i];
+  BasicPointSpan<T> operator[](int i) {
+    return BasicPointSpan<T>(points_.data() + size_t(i) * dimensions_, dimensions_);
   }
 
   const int size() const {
-    return points_.size();
+    return size_;
+  }
+
+  /**
+   * @brief Changes the number of points. Shrinking keeps the buffer, so a
+   *        problem can be reused as a batch of varying size; growing keeps
+   *        the existing points and zero-fills the new ones
+  */
+  void resize(int n) {
+    if (size_t(n) * dimensions_ > points_.size()) {
+      AlignedBuffer<T> points(size_t(n) * dimensions_);
+      std::copy(points_.data(), points_.data() + size_t(size_) * dimensions_, points.data());
+      points_ = std::move(points);
+    }
+    size_ = n;
+    columns_ = AlignedBuffer<T>();
+    norms_ = AlignedBuffer<T>();
   }
 
   const int dimensions() const {
-    return points_[0].size();
+    return dimensions_;
+  }
+
+  /**
+   * @brief Row-major coordinates: point i starts at data() + i * dimensions()
+  */
+  const T* data() const {
+    return points_.data();
+  }
+
+  T* data() {
+    return points_.data();
+  }
+
+  /**
+   * @brief Builds the column-major (structure of arrays) copy of the points.
+   *        It is a snapshot: call it again after modifying the points
+  */
+  void build_column_major() {
+    columns_ = AlignedBuffer<T>(size_t(size_) * dimensions_);
+    for (int i{0}; i < size_; ++i) {
+      for (int j{0}; j < dimensions_; ++j) {
+        columns_.data()[size_t(j) * size_ + i] = points_.data()[size_t(i) * dimensions_ + j];
+      }
+    }
+  }
+
+  const bool has_column_major() const {
+    return columns_.size() == size_t(size_) * dimensions_;
+  }
+
+  /**
+   * @brief Coordinate j of every point, contiguous. Requires build_column_major()
+  */
+  const T* column(int j) const {
+    return columns_.data() + size_t(j) * size_;
+  }
+
+  /**
+   * @brief Computes the squared norm of every point, for the blocked
+   *        distances. It is a snapshot: call it again after modifying the points
+  */
+  void build_norms() {
+    norms_ = AlignedBuffer<T>(size_);
+    for (int i{0}; i < size_; ++i) {
+      const T* point = points_.data() + size_t(i) * dimensions_;
+      double norm{0};
+      for (int j{0}; j < dimensions_; ++j) {
+        norm += double(point[j]) * point[j];
+      }
+      norms_.data()[i] = norm;
+    }
   }
+
+  const bool has_norms() const {
+    return norms_.size() == size_t(size_);
+  }
+
+  /**
+   * @brief Squared norm of every point, or null before build_norms()
+  */
+  const T* norms() const {
+    return has_norms() ? norms_.data() : nullptr;
+  }
+
  private:
-  std::vector<Point> points_;
+  int size_;
+  int dimensions_;
+  AlignedBuffer<T> points_;
+  AlignedBuffer<T> columns_;
+  AlignedBuffer<T> norms_;
 };
 
-#endif  // PROBLEM_H
\ No newline at end of file
+typedef BasicProblem<double> Problem;
+typedef BasicProblem<float> FloatProblem;
+
+#endif  // PROBLEM_H
@@ -0,0 +1,234 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file seeding.h
+ * @brief K-means seeding
+ *        This file contains the initializers of the k-means centroids:
+ *        uniform random points, k-means++ and k-means||
+ */
+
+#ifndef SEEDING_H
+#define SEEDING_H
+
+#include <vector>
+#include <set>
+#include <random>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "problem.h"
+#include "thread-pool.h"
+
+/**
+ * @brief Initializers of the k-means centroids
+ *        kRandom: k distinct points chosen uniformly
+ *        kPlusPlus: k-means++, each point chosen with probability
+ *                   proportional to its squared distance to the chosen ones
+ *        kParallel: k-means||, a few rounds that oversample points in
+ *                   parallel, reduced to k with a weighted k-means++
+*/
+enum class KMeansInitialization { kRandom, kPlusPlus, kParallel };
+
+namespace seeding {
+
+/**
+ * @brief Lowers min_distances[i] to the squared distance from point i to the
+ *        closest of `count` row-major centers, in chunks on the pool
+ * @param chunk_sums Sum of min_distances of each chunk, on return
+ */
+template <typename T>
+void lower_distances(const BasicProblem<T>& points, const T* centers, int count, ThreadPool& pool,
+                     std::vector<double>& min_distances, std::vector<double>& chunk_sums) {
+  int d = points.dimensions();
+  int chunks = chunk_sums.size();
+  pool.parallel_for(chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(points.size(), chunks, chunk);
+    std::vector<T> distances(count);
+    double sum{0};
+    for (int i{range.first}; i < range.second; ++i) {
+      batch_squared_l2(points[i].data(), centers, count, d, distances.data());
+      min_distances[i] = std::min<double>(min_distances[i], *std::min_element(distances.begin(), distances.end()));
+      sum += min_distances[i];
+    }
+    chunk_sums[chunk] = sum;
+  });
+}
+
+/**
+ * @brief Index i drawn with probability weights[i] / total. The chunk sums
+ *        locate the chunk first, so only one chunk is scanned
+ */
+inline int sample(const std::vector<double>& weights, const std::vector<double>& chunk_sums, std::mt19937& gen) {
+  double total = std::accumulate(chunk_sums.begin(), chunk_sums.end(), 0.0);
+  double target = std::uniform_real_distribution<>(0, total)(gen);
+  int chunks = chunk_sums.size();
+  int chunk{0};
+  while (chunk + 1 < chunks && target >= chunk_sums[chunk]) {
+    target -= chunk_sums[chunk++];
+  }
+  std::pair<int, int> range = chunk_range(weights.size(), chunks, chunk);
+  int last = range.first;
+  for (int i{range.first}; i < range.second; ++i) {
+    if (weights[i] <= 0) continue;
+    last = i;
+    if (target < weights[i]) return i;
+    target -= weights[i];
+  }
+  return last;  // Redondeo al final del trozo
+}
+
+/**
+ * @brief Centroids in double, whatever the precision they were chosen in
+ */
+template <typename T>
+std::vector<double> widen(const std::vector<T>& centroids) {
+  return std::vector<double>(centroids.begin(), centroids.end());
+}
+
+}  // namespace seeding
+
+/**
+ * @brief k distinct points of the problem chosen uniformly
+ * @return Row-major centroids
+ */
+template <typename T>
+std::vector<double> seed_random(const BasicProblem<T>& points, int k, std::mt19937& gen) {
+  std::set<int> random_centroids;
+  std::uniform_int_distribution<> dis(0, points.size() - 1);
+  while (int(random_centroids.size()) < k) {
+    random_centroids.insert(dis(gen));
+  }
+  int d = points.dimensions();
+  std::vector<double> centroids(size_t(k) * d);
+  int centroid{0};
+  for (auto it: random_centroids) {
+    std::copy(points[it].begin(), points[it].end(), centroids.begin() + size_t(centroid++) * d);
+  }
+  return centroids;
+}
+
+/**
+ * @brief k-means++ (Arthur and Vassilvitskii). The squared distance of every
+ *        point to the chosen centroids is only lowered against the last one
+ * @return Row-major centroids
+ */
+template <typename T>
+std::vector<double> seed_plus_plus(const BasicProblem<T>& points, int k, std::mt19937& gen, ThreadPool& pool) {
+  int d = points.dimensions();
+  std::vector<T> centroids(size_t(k) * d);
+  std::vector<double> min_distances(points.size(), INFINITY);
+  std::vector<double> chunk_sums(std::min(points.size(), pool.size()));
+  int first = std::uniform_int_distribution<>(0, points.size() - 1)(gen);
+  std::copy(points[first].begin(), points[first].end(), centroids.begin());
+  for (int c{1}; c < k; ++c) {
+    seeding::lower_distances(points, centroids.data() + size_t(c - 1) * d, 1, pool, min_distances, chunk_sums);
+    double total = std::accumulate(chunk_sums.begin(), chunk_sums.end(), 0.0);
+    // Si todos los puntos coinciden con algún centroide, se elige al azar
+    int next = total > 0 ? seeding::sample(min_distances, chunk_sums, gen)
+                         : std::uniform_int_distribution<>(0, points.size() - 1)(gen);
+    std::copy(points[next].begin(), points[next].end(), centroids.begin() + size_t(c) * d);
+  }
+  return seeding::widen(centroids);
+}
+
+/**
+ * @brief k-means|| (Bahmani et al.). Each round keeps every point with
+ *        probability min(1, oversampling·k·D(x)² / sum of D²), each chunk of
+ *        points with its own random stream; the candidates are weighted by
+ *        the points closest to them and reduced to k with k-means++
+ * @param rounds Oversampling rounds
+ * @param oversampling Expected candidates per round, as a multiple of k
+ * @return Row-major centroids
+ */
+template <typename T>
+std::vector<double> seed_parallel(const BasicProblem<T>& points, int k, std::mt19937& gen, ThreadPool& pool,
+                                  int rounds = 5, double oversampling = 2) {
+  int n = points.size();
+  int d = points.dimensions();
+  int chunks = std::min(n, pool.size());
+  std::vector<T> candidates;
+  std::vector<double> min_distances(n, INFINITY);
+  std::vector<double> chunk_sums(chunks);
+  int first = std::uniform_int_distribution<>(0, n - 1)(gen);
+  candidates.assign(points[first].begin(), points[first].end());
+  seeding::lower_distances(points, candidates.data(), 1, pool, min_distances, chunk_sums);
+
+  std::vector<std::vector<int>> chosen(chunks);
+  for (int round{0}; round < rounds; ++round) {
+    double total = std::accumulate(chunk_sums.begin(), chunk_sums.end(), 0.0);
+    if (total <= 0) break;
+    unsigned round_seed = gen();
+    pool.parallel_for(chunks, [&](int chunk) {
+      std::pair<int, int> range = chunk_range(n, chunks, chunk);
+      std::seed_seq sequence{round_seed, unsigned(chunk)};
+      std::mt19937 chunk_gen(sequence);
+      std::uniform_real_distribution<> uniform(0, 1);
+      chosen[chunk].clear();
+      for (int i{range.first}; i < range.second; ++i) {
+        if (uniform(chunk_gen) < oversampling * k * min_distances[i] / total) {
+          chosen[chunk].push_back(i);
+        }
+      }
+    });
+    size_t previous = candidates.size();
+    for (const std::vector<int>& chunk_chosen: chosen) {  // En orden de trozos: reproducible
+      for (int i: chunk_chosen) {
+        candidates.insert(candidates.end(), points[i].begin(), points[i].end());
+      }
+    }
+    int added = (candidates.size() - previous) / d;
+    if (added > 0) {
+      seeding::lower_distances(points, candidates.data() + previous, added, pool, min_distances, chunk_sums);
+    }
+  }
+
+  // Peso de cada candidato: puntos para los que es el más cercano
+  int count = candidates.size() / d;
+  std::vector<std::vector<double>> chunk_weights(chunks, std::vector<double>(count, 0));
+  pool.parallel_for(chunks, [&](int chunk) {
+    std::pair<int, int> range = chunk_range(n, chunks, chunk);
+    std::vector<T> distances(count);
+    for (int i{range.first}; i < range.second; ++i) {
+      batch_squared_l2(points[i].data(), candidates.data(), count, d, distances.data());
+      chunk_weights[chunk][std::min_element(distances.begin(), distances.end()) - distances.begin()]++;
+    }
+  });
+  std::vector<double> weights(count, 0);
+  for (const std::vector<double>& chunk_weight: chunk_weights) {
+    for (int c{0}; c < count; ++c) {
+      weights[c] += chunk_weight[c];
+    }
+  }
+  if (count <= k) {  // Pocos candidatos: se completan con k-means++
+    return seed_plus_plus(points, k, gen, pool);
+  }
+
+  // k-means++ ponderado sobre los candidatos
+  std::vector<T> centroids(size_t(k) * d);
+  std::vector<double> candidate_distances(count, INFINITY);
+  std::vector<double> probabilities(count);
+  std::vector<double> total(1);
+  total[0] = std::accumulate(weights.begin(), weights.end(), 0.0);
+  int next = seeding::sample(weights, total, gen);
+  for (int c{0}; c < k; ++c) {
+    const T* center = candidates.data() + size_t(next) * d;
+    std::copy(center, center + d, centroids.begin() + size_t(c) * d);
+    if (c + 1 == k) break;
+    total[0] = 0;
+    for (int t{0}; t < count; ++t) {
+      candidate_distances[t] = std::min<double>(candidate_distances[t], squared_l2(candidates.data() + size_t(t) * d, center, d));
+      probabilities[t] = weights[t] * candidate_distances[t];
+      total[0] += probabilities[t];
+    }
+    next = total[0] > 0 ? seeding::sample(probabilities, total, gen)
+                        : std::uniform_int_distribution<>(0, count - 1)(gen);
+  }
+  return seeding::widen(centroids);
+}
+
+#endif  // SEEDING_H
@@ -16,82 +16,151 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include <array>
+#include <random>
 #include "problem.h"
+#include "nearest-index.h"
+#include "blocked-distance.h"
+#include "fast-swap.h"
+#include "solver-control.h"
+#include "instrumentation.h"
 
 /**
- * @brief Defines a solution to the clustering problem
+ * @brief How the local search moves through a neighbourhood
+ *        kBestImprovement: the whole neighbourhood, then the best move
+ *        kFirstImprovement: the first improving move found (swaps and
+ *                           insertions; every elimination is priced at once)
+*/
+enum class LocalSearchStrategy { kBestImprovement, kFirstImprovement };
+
+/**
+ * @brief Options of the local search. Every one but the defaults trades
+ *        some quality for speed
+*/
+struct LocalSearchOptions {
+  LocalSearchStrategy strategy{LocalSearchStrategy::kBestImprovement};
+  bool random_order{false};     // RVND: vecindarios en orden aleatorio, barajado tras cada mejora
+  int candidate_list_size{0};   // Intercambios solo con los m puntos más cercanos a cada punto de servicio (0 = todos)
+};
+
+/**
+ * @brief Scratch state of the local search of one thread. Its buffers keep
+ *        their capacity from one search to the next, so once they have grown
+ *        a search allocates nothing
+*/
+struct SearchWorkspace {
+  DistanceIndex distances;     // Distancias de los puntos a la solución que se mejora
+  std::vector<double> losses;  // Pérdida de quitar cada punto de servicio
+  std::vector<int> candidates; // Candidatos de los intercambios con listas de candidatos
+  std::vector<char> marks;
+  // Listas compartidas por todos los hilos; sin ellas se prueban todos los puntos
+  std::shared_ptr<const CandidateLists> candidate_lists;
+  const SolverControl* control{nullptr};  // Límites del solver, comprobados entre movimientos
+};
+
+/**
+ * @brief Defines a solution to the clustering problem. A k-means solution
+ *        keeps its centroids in one contiguous buffer; a p-median solution
+ *        (GRASP, GVNS) only keeps the indices of its service points in the
+ *        problem and a bitset of them, so copying it allocates twice and
+ *        membership is O(1). The problem must outlive the solution
 */
 class Solution {
  public:
   /**
-   * @brief Creates a new solution
+   * @brief Creates a new solution of centroids
    * @param d Number of dimensions
   */
   Solution(int d) {
     dimensions_ = d;
   }
 
-  const Point& operator[](int i) const {
-    return points_[i];
+  /**
+   * @brief Creates a new solution of service points of a problem
+  */
+  Solution(const Problem& problem)
+      : problem_(&problem), members_((problem.size() + 63) / 64, 0) {
+    dimensions_ = problem.dimensions();
   }
 
-  Point& operator[](int i) {
-    return points_[i];
+  ConstPointSpan operator[](int i) const {
+    if (problem_) return (*problem_)[indices_[i]];
+    return ConstPointSpan(centroids_.data() + size_t(i) * dimensions_, dimensions_);
   }
 
   const int size() const {
-    return points_.size();
+    return problem_ ? indices_.size() : centroids_.size() / std::max(dimensions_, 1);
   }
 
   /**
-   * @brief Calculates the sum of distances of the solution
+   * @brief Penalty added to the objective for the number of points of the solution
    */
-  const double evaluate(const Problem& problem) {
+  const double penalty() const {
+    return size() * penalty_factor_;
+  }
+
+  /**
+   * @brief Calculates the sum of distances of the solution. With many
+   *        centers in many dimensions the nearest center of each point is
+   *        found with the blocked distances, and only the distance to it is
+   *        computed again exactly
+   */
+  const double evaluate(const Problem& problem) const {
+    if (size() >= 64 && dimensions_ > 32) return evaluate_blocked(problem);
+    // Distancias al cuadrado: solo se hace la raíz de la mínima
+    std::unique_ptr<NearestIndex> index = make_nearest_index(NearestIndexKind::kAuto, size(), dimensions_);
+    index->build(*this, dimensions_);
     double sum_of_distances{0};
     for (int i{0}; i < problem.size(); ++i) {  // por cada punto
-      double min_distance{INFINITY};
-      for (int j{0}; j < points_.size(); ++j) {  // por cada punto de servicio
-        double distance{euclidean_distance(problem[i], points_[j])};
-        if (distance < min_distance) {
-          min_distance = distance;
-        }
+      sum_of_distances += sqrt(index->nearest(problem[i].data()).first_distance);
+    }
+    return sum_of_distances + penalty();
+  }
+
+  const double evaluate_blocked(const Problem& problem) const {
+    std::vector<double> centers(size_t(size()) * dimensions_);
+    for (int c{0}; c < size(); ++c) {
+      std::copy((*this)[c].begin(), (*this)[c].end(), centers.begin() + size_t(c) * dimensions_);
+    }
+    BlockedDistances<double> blocked;
+    blocked.set_centers(centers.data(), size(), dimensions_);
+    int labels[blocked::kBlockRows];
+    double distances[blocked::kBlockRows];
+    double sum_of_distances{0};
+    for (int start{0}; start < problem.size(); start += blocked::kBlockRows) {
+      int end = std::min(problem.size(), start + blocked::kBlockRows);
+      blocked.nearest(problem.data(), problem.norms(), start, end, labels, distances);
+      for (int i{start}; i < end; ++i) {
+        const double* center = centers.data() + size_t(labels[i - start]) * dimensions_;
+        sum_of_distances += sqrt(squared_l2(problem[i].data(), center, dimensions_));
       }
-      sum_of_distances += min_distance;
     }
-    return sum_of_distances + points_.size() * penalty_factor_;
+    return sum_of_distances + penalty();
   }
 
   /**
    * @brief Calculates the sum of distances of the solution and the distances of each point to the solution
    */
   const double evaluate(const Problem& problem, DistanceIndex& distances) {
-    double sum_of_distances{0};
-    distances = DistanceIndex(problem.size(), {0, 0});
-    for (int i{0}; i < problem.size(); ++i) {  // por cada punto
-      double min_distance{INFINITY};
-      for (int j{0}; j < points_.size(); ++j) {  // por cada punto de servicio
-        double distance{euclidean_distance(problem[i], points_[j])};
-        if (distance < min_distance) {
-          min_distance = distance;
-          distances[i] = {distance, j};
-        }
-      }
-      sum_of_distances += min_distance;
-    }
-    double result_check{0};
-    for (int i{0}; i < problem.size(); ++i) {
-      result_check += distances[i].first;
-    }
-    
-    return sum_of_distances  + points_.size() * penalty_factor_;
+    distances.build(problem, *this);
+    return distances.sum() + penalty();
   }
 
+  /**
+   * @brief Same service points (p-median) or same centroids up to 0.001
+   */
   const bool operator==(const Solution& other) {
-    if (points_.size() != other.points_.size()) return false;
-    for (int i{0}; i < points_.size(); ++i) { // por cada punto
-      if (points_[i].size() != other.points_[i].size()) return false;
-      for (int j{0}; j < points_[i].size(); ++j) { // por cada dimension
-        if (fabs(points_[i][j] - other.points_[i][j]) > 0.001) return false;
+    if (problem_ && other.problem_) return indices_ == other.indices_;
+    if (size() != other.size()) return false;
+    for (int i{0}; i < size(); ++i) { // por cada punto
+      ConstPointSpan point = (*this)[i];
+      ConstPointSpan other_point = other[i];
+      for (int j{0}; j < dimensions_; ++j) { // por cada dimension
+        if (fabs(point[j] - other_point[j]) > 0.001) return false;
       }
     }
     return true;
@@ -101,8 +170,59 @@ class Solution {
     return !(*this == other);
   }
 
-  void push_back(Point point) {
-    points_.push_back(point);
+  /**
+   * @brief Appends a centroid
+   */
+  void push_back(ConstPointSpan point) {
+    centroids_.insert(centroids_.end(), point.begin(), point.end());
+  }
+
+  /**
+   * @brief Appends the point j of the problem as a service point
+   */
+  void add(int j) {
+    indices_.push_back(j);
+    members_[j / 64] |= uint64_t(1) << (j % 64);
+  }
+
+  /**
+   * @brief Removes every service point or centroid, keeping the buffers
+   */
+  void clear() {
+    centroids_.clear();
+    indices_.clear();
+    std::fill(members_.begin(), members_.end(), 0);
+  }
+
+  /**
+   * @brief Replaces the service point at position c with the point j
+   */
+  void replace(int c, int j) {
+    members_[indices_[c] / 64] &= ~(uint64_t(1) << (indices_[c] % 64));
+    indices_[c] = j;
+    members_[j / 64] |= uint64_t(1) << (j % 64);
+  }
+
+  /**
+   * @brief Removes the service point at position c; the later ones move back
+   */
+  void remove(int c) {
+    members_[indices_[c] / 64] &= ~(uint64_t(1) << (indices_[c] % 64));
+    indices_.erase(indices_.begin() + c);
+  }
+
+  /**
+   * @brief Index in the problem of the service point at position c
+   */
+  const int index(int c) const {
+    return indices_[c];
+  }
+
+  /**
+   * @brief True if the point j of the problem is a service point
+   */
+  const bool contains(int j) const {
+    return (members_[j / 64] >> (j % 64)) & 1;
   }
 
   const int dimensions() {
@@ -110,170 +230,199 @@ class Solution {
   }
 
   Solution local_search(const Problem& problem) {
-    // Intercambio, inserción y eliminación
-    DistanceIndex distances;
+    return local_search(problem, PointDistances(problem));
+  }
+
+  /**
+   * @brief Local search that takes the distances between points of the
+   *        problem from a precomputed backend
+   */
+  Solution local_search(const Problem& problem, const PointDistances& point_distances) {
+    SearchWorkspace workspace;
     Solution best_solution(*this);
-    Solution new_solution(*this);
-    double best_solution_value{evaluate(problem, distances)};
-    double new_solution_value{best_solution_value};
-    DistanceIndex best_solution_distances{distances};
-    DistanceIndex new_solution_distances{distances};
-    do {
-      best_solution = new_solution;
-      best_solution_value = new_solution_value;
-      best_solution_distances = new_solution_distances;
-
-      new_solution = best_solution.swap_search(problem, new_solution_distances);
-      new_solution_value = new_solution.evaluate(problem, new_solution_distances);
-      if (new_solution_value < best_solution_value) {
-        continue;
-      }
-      new_solution = best_solution.insertion_search(problem, new_solution_distances);
-      new_solution_value = new_solution.evaluate(problem, new_solution_distances);
-      if (new_solution_value < best_solution_value) {
-        continue;
-      }
-      new_solution = best_solution.elimination_search(problem, new_solution_distances);
-      new_solution_value = new_solution.evaluate(problem, new_solution_distances);
-    } while (new_solution_value < best_solution_value);
-    distances = best_solution_distances;
+    best_solution.improve(problem, point_distances, workspace);
     return best_solution;
   }
 
-  // Solution rvnd(const Problem& problem) {
-  //   // Intercambio, inserción y eliminación
-  //   DistanceIndex distances;
-  //   Solution best_solution(*this);
-  //   Solution new_solution(*this);
-  //   double best_solution_value{evaluate(problem, distances)};
-  //   double new_solution_value{best_solution_value};
-  //   DistanceIndex best_solution_distances{distances};
-  //   DistanceIndex new_solution_distances{distances};
-  //   // numero aleatorio del 1 al 3
-  //   int random_number{rand() % 3 + 1};
-  // }
-
-  bool isInSolution(const Point& point) {
-    for (int i{0}; i < points_.size(); ++i) {
-      if (points_[i] == point) {
-        return true;
+  /**
+   * @brief Local search in place, on the buffers of a workspace that the
+   *        caller keeps between searches. The swap, insertion and
+   *        elimination neighbourhoods are explored in that order, starting
+   *        over after every improvement (VND), or in a random order that is
+   *        shuffled again after every improvement (RVND). It stops early,
+   *        with the moves applied so far, when the control of the
+   *        workspace asks to
+   * @param gen Random generator of the caller, needed for the random order
+   * @return Objective of the improved solution
+   */
+  double improve(const Problem& problem, const PointDistances& point_distances, SearchWorkspace& workspace,
+                 const LocalSearchOptions& options = LocalSearchOptions(), std::mt19937* gen = nullptr) {
+    if (!problem_) {
+      throw std::logic_error("The local search needs a solution of service points");
+    }
+    if (options.random_order && !gen) {
+      throw std::invalid_argument("The random neighbourhood order needs a random generator");
+    }
+    // Intercambio, inserción y eliminación, aplicados sobre la misma caché de distancias
+    INSTRUMENT_SCOPE(kLocalSearch);
+    DistanceIndex& distances = workspace.distances;
+    double value{evaluate(problem, distances)};
+    bool first = options.strategy == LocalSearchStrategy::kFirstImprovement;
+    auto search = [&](int neighbourhood) {
+      switch (neighbourhood) {
+        case 0:
+          return swap_search(problem, distances, point_distances, workspace, first, value);
+        case 1:
+          return insertion_search(problem, distances, point_distances, first, workspace.control, value);
+        default:
+          return elimination_search(problem, distances, workspace.losses, value);
+      }
+    };
+    auto stopped = [&workspace]() {
+      return workspace.control && workspace.control->stop_requested();
+    };
+    if (!options.random_order) {
+      while (!stopped() && (search(0) || search(1) || search(2))) {}
+      return value;
+    }
+    std::array<int, 3> order{0, 1, 2};
+    std::shuffle(order.begin(), order.end(), *gen);
+    for (size_t n{0}; n < order.size() && !stopped(); ) {
+      if (search(order[n])) {
+        std::shuffle(order.begin(), order.end(), *gen);
+        n = 0;
+      } else {
+        ++n;
       }
     }
-    return false;
+    return value;
   }
 
  private:
-  // Centroids if kmeans, points of service if grasp
-  std::vector<Point> points_;
+  std::vector<double> centroids_;  // K-means: centroides seguidos, k·d valores
+  const Problem* problem_{nullptr};  // P-mediana: problema de los puntos de servicio
+  std::vector<int> indices_;         // P-mediana: índice de cada punto de servicio
+  std::vector<uint64_t> members_;    // P-mediana: bitset de los puntos que están en la solución
   int dimensions_;
   int penalty_factor_ = 13; // 13
+  instrumentation::CopyCounter copies_;
 
-  const double evaluate_insertion(const Problem& points, DistanceIndex& distances, int new_index_from_points) {
-    double sum_of_distances{0};
-    for (int i{0}; i < points.size(); ++i) {
-      double distance{euclidean_distance(points[i], points[new_index_from_points])};
-      if (distance < distances[i].first) {
-        distances[i] = {distance, new_index_from_points};
-      }
-      sum_of_distances += distances[i].first;
-    }
-    return sum_of_distances + (points_.size() + 1) * penalty_factor_;
-  }
-
-  const double evaluate_elimination(const Problem& points, DistanceIndex& distances, int old_index_from_solution) {
+  /**
+   * @brief Objective of the solution if a point of the problem were added
+   */
+  const double evaluate_insertion(const Problem& points, const DistanceIndex& distances,
+                                  const PointDistances& point_distances, int new_index_from_points) {
     double sum_of_distances{0};
     for (int i{0}; i < points.size(); ++i) {
-      if (distances[i].second == old_index_from_solution) {
-        double min_distance{INFINITY};
-        for (int j{0}; j < this->points_.size(); ++j) {
-          if (j != old_index_from_solution) {
-            double distance{euclidean_distance(points[i], this->points_[j])};
-            if (distance < min_distance) {
-              min_distance = distance;
-              distances[i] = {distance, j};
-            }
-          }
-        }
-      }
-      sum_of_distances += distances[i].first;
+      double distance{point_distances(i, new_index_from_points)};
+      sum_of_distances += std::min(distance, distances[i].distance);
     }
-    return sum_of_distances + (points_.size() - 1) * penalty_factor_;
+    return sum_of_distances + (size() + 1) * penalty_factor_;
   }
 
-  const double evaluate_swap(const Problem& points, DistanceIndex& distances, int old_index_from_solution, int new_index_from_points) {
-    double sum_of_distances{0};
-    for (int i{0}; i < points.size(); ++i) {
-      if (distances[i].second == old_index_from_solution) {
-        double min_distance{INFINITY};
-        for (int j{0}; j < this->points_.size(); ++j) {
-          if (j != old_index_from_solution) {
-            double distance{euclidean_distance(points[i], this->points_[j])};
-            if (distance < min_distance) {
-              min_distance = distance;
-              distances[i] = {distance, j};
-            }
-          }
-        }
-      }
-      double new_distance = euclidean_distance(points[i], points[new_index_from_points]);
-      if (distances[i].first > new_distance) {
-        distances[i] = {new_distance, new_index_from_points};
-      }
-      sum_of_distances += distances[i].first;
-    }
-    return sum_of_distances + points_.size() * penalty_factor_;
+  /**
+   * @brief True if new_value is better than value by more than the relative
+   *        rounding error `tolerance`
+   */
+  static bool improves(double new_value, double value, double tolerance = 1e-12) {
+    return new_value < value - tolerance * value;
   }
 
-  Solution insertion_search(const Problem& problem, DistanceIndex& distances) {
-    Solution best_solution(*this);
-    double best_solution_value{sum_distances(distances) + points_.size() * penalty_factor_};
-    float penalty{0};  // 20% de penalización
+  /**
+   * @brief Adds the point of the problem that improves the objective the
+   *        most, or the first one that improves it
+   * @param distances Distances of the solution, updated on return
+   * @param point_distances Distances between points of the problem
+   * @param first Stop at the first improving point
+   * @param control Limits of the solver, or null: when it asks to stop, the
+   *                best point seen so far is taken
+   * @param value Objective of the solution, updated on return
+   * @return True if some point was added
+   */
+  bool insertion_search(const Problem& problem, DistanceIndex& distances, const PointDistances& point_distances,
+                        bool first, const SolverControl* control, double& value) {
+    INSTRUMENT_SCOPE(kInsertion);
+    int best_index{-1};
+    double best_value{value};
     for (int j{0}; j < problem.size(); ++j) { // por cada punto
-      Solution new_solution(*this);
-      DistanceIndex new_distances = distances;
-      double new_solution_value = new_solution.evaluate_insertion(problem, new_distances, j);
-      if (new_solution_value < best_solution_value * (1 - penalty)) {
-        new_solution.push_back(problem[j]);
-        best_solution = new_solution;
-        best_solution_value = new_solution_value;
+      if (contains(j)) continue;
+      if (control && control->stop_requested()) break;
+      INSTRUMENT_COUNT(kEvaluations, 1);
+      double new_value = evaluate_insertion(problem, distances, point_distances, j);
+      if (new_value < best_value) {
+        best_index = j;
+        best_value = new_value;
+        if (first && improves(best_value, value, point_distances.tolerance())) break;
       }
     }
-    return best_solution;
+    if (best_index < 0 || !improves(best_value, value, point_distances.tolerance())) return false;
+    INSTRUMENT_COUNT(kMoves, 1);
+    add(best_index);
+    distances.add_center(problem, problem[best_index], size() - 1);
+    value = distances.sum() + penalty();
+    return true;
   }
 
-  Solution elimination_search(const Problem& problem, DistanceIndex& distances) {
-    Solution best_solution(*this);
-    double best_solution_value{sum_distances(distances) + points_.size() * penalty_factor_};
-    float boost{0};  // 5% de aumento
-    for (int i{0}; i < points_.size(); ++i) { // por cada punto de la solución
-      Solution new_solution(*this);
-      DistanceIndex new_distances = distances;
-      double new_solution_value = new_solution.evaluate_elimination(problem, new_distances, i);
-      if (new_solution_value * (1 - boost) < best_solution_value) {
-        new_solution.points_.erase(new_solution.points_.begin() + i);
-        best_solution = new_solution;
-        best_solution_value = new_solution_value;
-      }
-    }
-    return best_solution;
+  /**
+   * @brief Removes the service point that improves the objective the most.
+   *        The second nearest distances price every elimination in one pass,
+   *        and removing one only touches the points it served
+   * @param distances Distances of the solution, updated on return
+   * @param losses Scratch buffer for the loss of each service point
+   * @param value Objective of the solution, updated on return
+   * @return True if some service point was removed
+   */
+  bool elimination_search(const Problem& problem, DistanceIndex& distances, std::vector<double>& losses,
+                          double& value) {
+    if (size() < 2) return false;
+    INSTRUMENT_SCOPE(kElimination);
+    INSTRUMENT_COUNT(kEvaluations, size());
+    distances.removal_losses(problem, *this, losses);
+    int best_index = std::min_element(losses.begin(), losses.end()) - losses.begin();
+    double best_value = distances.sum() + losses[best_index] + (size() - 1) * penalty_factor_;
+    if (!improves(best_value, value)) return false;
+    INSTRUMENT_COUNT(kMoves, 1);
+    remove(best_index);
+    distances.remove_center(problem, *this, best_index);
+    value = distances.sum() + penalty();
+    return true;
   }
 
-  Solution swap_search(const Problem& problem, DistanceIndex& distances) {
-    Solution best_solution(*this);
-    double best_solution_value{sum_distances(distances) + points_.size() * penalty_factor_};
-    for (int i{0}; i < points_.size(); ++i) { // por cada punto de la solución
-      for (int j{0}; j < problem.size(); ++j) { // por cada punto
-        Solution new_solution(*this);
-        DistanceIndex new_distances = distances;
-        double new_solution_value = new_solution.evaluate_swap(problem, new_distances, i, j);
-        if (new_solution_value < best_solution_value) {
-          new_solution[i] = problem[j];
-          best_solution = new_solution;
-          best_solution_value = new_solution_value;
-        }
+  /**
+   * @brief Applies best or first improvement swaps in place until none
+   *        improves. The fast swap engine evaluates every (service point,
+   *        candidate) pair from the nearest and second nearest distances,
+   *        without copying the solution or the distances. With candidate
+   *        lists, only the points near a service point are candidates
+   * @param distances Distances of the solution, updated on return
+   * @param point_distances Distances between points of the problem
+   * @param workspace Scratch buffers and candidate lists
+   * @param first Apply the first improving swap found
+   * @param value Objective of the solution, updated on return
+   * @return True if some swap was applied
+   */
+  bool swap_search(const Problem& problem, DistanceIndex& distances, const PointDistances& point_distances,
+                   SearchWorkspace& workspace, bool first, double& value) {
+    INSTRUMENT_SCOPE(kSwap);
+    SwapEngine<Solution> engine(problem, *this, distances, point_distances, workspace.losses, workspace.control);
+    const std::vector<int>* candidates = workspace.candidate_lists ? &workspace.candidates : nullptr;
+    bool improved{false};
+    while (!workspace.control || !workspace.control->stop_requested()) {
+      if (candidates) {
+        workspace.candidate_lists->gather(*this, problem.size(), workspace.candidates, workspace.marks);
       }
+      SwapEngine<Solution>::Move move = first ? engine.first_swap(-point_distances.tolerance() * value, candidates)
+                                              : engine.best_swap(candidates);
+      if (move.out < 0 || !improves(value + move.delta, value, point_distances.tolerance())) break;
+      INSTRUMENT_COUNT(kMoves, 1);
+      engine.apply(move);
+      value += move.delta;
+      improved = true;
     }
-    return best_solution;
+    if (improved) {
+      value = distances.sum() + penalty();
+    }
+    return improved;
   }
 };
 
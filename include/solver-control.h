@@ -0,0 +1,64 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file solver-control.h
+ * @brief CancellationToken and SolverControl classes
+ *        This file contains what a caller uses to bound a running solver:
+ *        a deadline, a cancellation flag and a callback for every
+ *        improvement of the best solution
+ */
+
+#ifndef SOLVER_CONTROL_H
+#define SOLVER_CONTROL_H
+
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <optional>
+#include <functional>
+
+class Solution;
+
+/**
+ * @brief Flag shared by all its copies: cancelling one cancels them all,
+ *        from any thread
+*/
+class CancellationToken {
+ public:
+  CancellationToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  void cancel() {
+    flag_->store(true);
+  }
+
+  const bool cancelled() const {
+    return flag_->load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+/**
+ * @brief Limits of a run beyond the stopping rules of the algorithm. The
+ *        solvers check them between iterations and between the moves of a
+ *        local search, so a run stops shortly after the deadline or the
+ *        cancellation, always with a valid solution
+*/
+struct SolverControl {
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  CancellationToken cancellation;
+  // Llamado con cada mejora de la mejor solución y su objetivo, de uno en uno
+  std::function<void(const Solution&, double)> on_improvement;
+
+  const bool stop_requested() const {
+    return cancellation.cancelled() || (deadline && std::chrono::steady_clock::now() >= *deadline);
+  }
+};
+
+#endif  // SOLVER_CONTROL_H
@@ -0,0 +1,151 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file solver.h
+ * @brief Solver class
+ *        This file contains the anytime interface shared by K-Means, GRASP
+ *        and GVNS: a run bounded by a SolverControl whose best solution can
+ *        be read at any moment
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <mutex>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include "k-means.h"
+#include "grasp.h"
+#include "gvns.h"
+#include "solver-control.h"
+
+/**
+ * @brief A solution and its objective: the SSE for K-Means, the sum of
+ *        distances plus the penalty for GRASP and GVNS
+*/
+struct SolverResult {
+  Solution solution;
+  double value;
+};
+
+/**
+ * @brief Anytime solver. solve() runs the algorithm until its own stopping
+ *        rule, the deadline or the cancellation of the control; meanwhile
+ *        best() returns the best solution found so far from any thread
+*/
+class Solver {
+ public:
+  virtual ~Solver() {}
+
+  /**
+   * @brief Solves the problem with k centers (the initial k of GRASP and
+   *        GVNS, that may add or remove service points)
+   * @param control Limits of the run; its on_improvement is still called
+   * @return Best solution found
+  */
+  SolverResult solve(const Problem& problem, int k, const SolverControl& control = SolverControl()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      best_.reset();
+    }
+    SolverControl watched = control;
+    watched.on_improvement = [this, &control](const Solution& solution, double value) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Con el mismo valor se queda la última: K-Means avisa de sus centroides finales así
+        if (!best_ || value <= best_->value) best_.emplace(SolverResult{solution, value});
+      }
+      if (control.on_improvement) control.on_improvement(solution, value);
+    };
+    run(problem, k, watched);
+    std::optional<SolverResult> result = best();
+    if (!result) {
+      throw std::logic_error("The solver finished without a solution");
+    }
+    return *result;
+  }
+
+  /**
+   * @brief Best solution of the current or the last run, if there is one yet
+  */
+  std::optional<SolverResult> best() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return best_;
+  }
+
+ protected:
+  /**
+   * @brief Runs the algorithm, reporting every improvement to control
+  */
+  virtual void run(const Problem& problem, int k, const SolverControl& control) = 0;
+
+ private:
+  mutable std::mutex mutex_;
+  std::optional<SolverResult> best_;
+};
+
+class KMeansSolver : public Solver {
+ public:
+  /**
+   * @param single Copy in float of the problems given to solve(), or null.
+   *               K-Means then runs on it instead
+  */
+  KMeansSolver(const KMeansOptions& options = KMeansOptions(), const FloatProblem* single = nullptr)
+      : options_(options), single_(single) {}
+
+ protected:
+  void run(const Problem& problem, int k, const SolverControl& control) override {
+    KMeansOptions options = options_;
+    options.control = control;
+    if (single_) {
+      KMeans(options).solve(*single_, k);
+    } else {
+      KMeans(options).solve(problem, k);
+    }
+  }
+
+ private:
+  KMeansOptions options_;
+  const FloatProblem* single_;
+};
+
+class GraspSolver : public Solver {
+ public:
+  GraspSolver(const GraspOptions& options = GraspOptions(), int lrc_size = 3)
+      : options_(options), lrc_size_(lrc_size) {}
+
+ protected:
+  void run(const Problem& problem, int k, const SolverControl& control) override {
+    GraspOptions options = options_;
+    options.control = control;
+    Grasp(options).solve(problem, k, lrc_size_);
+  }
+
+ private:
+  GraspOptions options_;
+  int lrc_size_;
+};
+
+class GVNSSolver : public Solver {
+ public:
+  GVNSSolver(const GVNSOptions& options = GVNSOptions(), bool rvnd = false) : options_(options), rvnd_(rvnd) {}
+
+ protected:
+  void run(const Problem& problem, int k, const SolverControl& control) override {
+    GVNSOptions options = options_;
+    options.control = control;
+    GVNS(options).solve(problem, k, rvnd_);
+  }
+
+ private:
+  GVNSOptions options_;
+  bool rvnd_;
+};
+
+#endif  // SOLVER_H
@@ -0,0 +1,163 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file storage.h
+ * @brief Point storage
+ *        This file contains the aligned buffer that backs the problem and
+ *        the non-owning spans used to access its points
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <memory>
+#include <utility>
+
+#define STORAGE_ALIGNMENT 64
+
+/**
+ * @brief Non-owning view over the coordinates of a point
+ * @tparam T Scalar type (const-qualified for read-only views)
+*/
+template <typename T>
+class BasicPointSpan {
+ public:
+  BasicPointSpan(T* data, int size) : data_(data), size_(size) {}
+
+  /**
+   * @brief Views the coordinates of a point stored in a std::vector
+  */
+  template <typename U>
+  BasicPointSpan(std::vector<U>& point) : data_(point.data()), size_(point.size()) {}
+
+  template <typename U>
+  BasicPointSpan(const std::vector<U>& point) : data_(point.data()), size_(point.size()) {}
+
+  /**
+   * @brief Allows a mutable span to be passed where a read-only one is expected
+  */
+  template <typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+  BasicPointSpan(const BasicPointSpan<U>& other) : data_(other.data()), size_(other.size()) {}
+
+  T& operator[](int i) const {
+    return data_[i];
+  }
+
+  T* data() const {
+    return data_;
+  }
+
+  const int size() const {
+    return size_;
+  }
+
+  T* begin() const {
+    return data_;
+  }
+
+  T* end() const {
+    return data_ + size_;
+  }
+
+ private:
+  T* data_;
+  int size_;
+};
+
+typedef BasicPointSpan<double> PointSpan;
+typedef BasicPointSpan<const double> ConstPointSpan;
+
+/**
+ * @brief Zero-initialised buffer aligned to STORAGE_ALIGNMENT bytes. It can
+ *        also view memory owned by someone else, such as a memory-mapped
+ *        file; copies of a buffer are always owned
+ * @tparam T Scalar type
+*/
+template <typename T>
+class AlignedBuffer {
+ public:
+  AlignedBuffer() : data_(nullptr), size_(0) {}
+
+  explicit AlignedBuffer(size_t size) : data_(allocate(size)), size_(size) {
+    std::fill(data_, data_ + size_, T(0));
+  }
+
+  /**
+   * @brief Views external memory without copying it
+   * @param data First element
+   * @param size Number of elements
+   * @param owner Keeps the memory alive while the buffer uses it
+  */
+  AlignedBuffer(T* data, size_t size, std::shared_ptr<void> owner)
+      : data_(data), size_(size), owner_(std::move(owner)) {}
+
+  AlignedBuffer(const AlignedBuffer& other) : data_(allocate(other.size_)), size_(other.size_) {
+    std::copy(other.data_, other.data_ + size_, data_);
+  }
+
+  AlignedBuffer(AlignedBuffer&& other) noexcept
+      : data_(other.data_), size_(other.size_), owner_(std::move(other.owner_)) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  AlignedBuffer& operator=(AlignedBuffer other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(owner_, other.owner_);
+    return *this;
+  }
+
+  ~AlignedBuffer() {
+    if (!owner_) {
+      release(data_);
+    }
+  }
+
+  T* data() {
+    return data_;
+  }
+
+  const T* data() const {
+    return data_;
+  }
+
+  const size_t size() const {
+    return size_;
+  }
+
+  /**
+   * @brief True when the memory belongs to an external owner
+  */
+  const bool is_view() const {
+    return static_cast<bool>(owner_);
+  }
+
+ private:
+  T* data_;
+  size_t size_;
+  std::shared_ptr<void> owner_;
+
+  static T* allocate(size_t size) {
+    if (size == 0) return nullptr;
+    return static_cast<T*>(::operator new(size * sizeof(T), std::align_val_t(STORAGE_ALIGNMENT)));
+  }
+
+  static void release(T* data) {
+    if (data != nullptr) {
+      ::operator delete(data, std::align_val_t(STORAGE_ALIGNMENT));
+    }
+  }
+};
+
+#endif  // STORAGE_H
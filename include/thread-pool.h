@@ -0,0 +1,195 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Diseño y Análisis de Algoritmos
+ *
+ * @author Miguel Luna García
+ * @since 17 Oct 2026
+ * @file thread-pool.h
+ * @brief ThreadPool class
+ *        This class runs the chunks of a parallel loop on a fixed set of threads
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include <exception>
+#include <cstdint>
+#include "instrumentation.h"
+
+/**
+ * @brief Fixed-size pool of threads for fork-join loops.
+ *        The calling thread also runs chunks, so a pool of size 1 starts no
+ *        threads at all. Only one parallel_for may run at a time
+*/
+class ThreadPool {
+ public:
+  /**
+   * @brief Creates a new pool
+   * @param threads Number of threads including the caller (0 = hardware concurrency)
+  */
+  explicit ThreadPool(int threads = 1) {
+    if (threads <= 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i{1}; i < threads; ++i) {
+      workers_.emplace_back([this]() { worker_loop(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker: workers_) {
+      worker.join();
+    }
+  }
+
+  const int size() const {
+    return workers_.size() + 1;
+  }
+
+  /**
+   * @brief Runs body(chunk) for every chunk in [0, chunks) and waits for all
+   *        of them. Which thread runs a chunk is not fixed, so the result of
+   *        a chunk must depend only on its index. If chunks throw, the first
+   *        exception is rethrown here once every thread has stopped
+  */
+  template <typename Body>
+  void parallel_for(int chunks, Body&& body) {
+    if (chunks <= 0) return;
+    if (workers_.empty() || chunks == 1) {
+      for (int chunk{0}; chunk < chunks; ++chunk) {
+        body(chunk);
+      }
+      return;
+    }
+    Job job;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++generation_;
+      job = {uint32_t(generation_), chunks, &body,
+             [](void* context, int chunk) { (*static_cast<Body*>(context))(chunk); },
+             instrumentation::current_phase()};
+      job_ = job;
+      next_claim_.store(uint64_t(job.generation) << 32);
+      pending_chunks_.store(chunks);
+    }
+    wake_.notify_all();
+    run_chunks(job);
+    // Un hilo que despierte tarde para este trabajo solo puede reclamar trozos con su
+    // generación, así que no ejecuta nada del siguiente aunque aún no haya salido
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_chunks_.load() == 0 && active_workers_ == 0; });
+    job_.context = nullptr;
+    if (error_) {
+      std::exception_ptr error = error_;
+      error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  bool stop_{false};
+  /**
+   * @brief A parallel loop. Every thread works on its own copy, taken under
+   *        the mutex, so the next loop can replace job_ at any time
+  */
+  struct Job {
+    uint32_t generation;
+    int chunks;
+    void* context;
+    void (*invoke)(void*, int);
+    instrumentation::Phase phase;  // Fase del llamador, para los contadores
+  };
+
+  unsigned long generation_{0};
+  int active_workers_{0};
+  std::exception_ptr error_;
+  Job job_{0, 0, nullptr, nullptr, instrumentation::Phase::kNone};
+  std::atomic<uint64_t> next_claim_{0};  // Generación (32 bits altos) y siguiente trozo
+  std::atomic<int> pending_chunks_{0};
+
+  /**
+   * @brief Claims the next chunk of a job; false once they are all claimed
+   *        or the pool has moved on to another job
+  */
+  bool claim(const Job& job, int& chunk) {
+    uint64_t claim = next_claim_.load();
+    while ((claim >> 32) == job.generation && int(claim & 0xffffffffu) < job.chunks) {
+      if (next_claim_.compare_exchange_weak(claim, claim + 1)) {
+        chunk = int(claim & 0xffffffffu);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void run_chunks(const Job& job) {
+    int chunk;
+    while (claim(job, chunk)) {
+      try {
+        job.invoke(job.context, chunk);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) error_ = std::current_exception();
+      }
+      pending_chunks_.fetch_sub(1);
+    }
+  }
+
+  void worker_loop() {
+    unsigned long seen_generation{0};
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&]() { return stop_ || generation_ != seen_generation; });
+        if (stop_) return;
+        seen_generation = generation_;
+        job = job_;
+        ++active_workers_;
+      }
+      {
+        INSTRUMENT_ADOPT(job.phase);
+        run_chunks(job);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_workers_;
+      }
+      done_.notify_all();
+    }
+  }
+};
+
+/**
+ * @brief Splits [0, size) into `chunks` contiguous ranges and returns the
+ *        bounds of range `chunk`
+*/
+inline std::pair<int, int> chunk_range(int size, int chunks, int chunk) {
+  int base = size / chunks;
+  int extra = size % chunks;
+  int begin = chunk * base + std::min(chunk, extra);
+  return {begin, begin + base + (chunk < extra ? 1 : 0)};
+}
+
+#endif  // THREAD_POOL_H
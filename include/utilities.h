@@ -16,34 +16,31 @@
 
 #include <vector>
 #include <cmath>
+#include "storage.h"
+#include "distance.h"
 
 typedef std::vector<double> Point;
 typedef std::vector<Point> Cluster;
-typedef std::vector<std::pair<double, int>> DistanceIndex;
 
 /**
- * @brief Calculates the euclidean distance between two points
+ * @brief Calculates the squared euclidean distance between two points.
+ *        Use it to compare distances, it saves the square root
  * @param a First point
  * @param b Second point
- * @return Euclidean distance between a and b
+ * @return Squared euclidean distance between a and b
  */
-double euclidean_distance(const Point& a, const Point& b) {
-  double distance{0};
-  for (int i{0}; i < a.size(); ++i) {
-    distance += (a[i] - b[i]) * (a[i] - b[i]);
-  }
-  return sqrt(distance);
+double squared_euclidean_distance(ConstPointSpan a, ConstPointSpan b) {
+  return squared_l2(a.data(), b.data(), a.size());
 }
 
 /**
- * @brief Calculates the sum of distances of the solution
+ * @brief Calculates the euclidean distance between two points
+ * @param a First point
+ * @param b Second point
+ * @return Euclidean distance between a and b
  */
-const double sum_distances(const DistanceIndex& distances) {
-  double sum_of_distances{0};
-  for (int i{0}; i < distances.size(); ++i) {
-    sum_of_distances += distances[i].first;
-  }
-  return sum_of_distances;
+double euclidean_distance(ConstPointSpan a, ConstPointSpan b) {
+  return l2(a.data(), b.data(), a.size());
 }
 
 #endif  // UTILITIES_H
\ No newline at end of file
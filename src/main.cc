@@ -16,123 +16,162 @@
 #include <filesystem>
 #include <vector>
 #include <chrono>
+#include <algorithm>
 
 #include "k-means.h"
 #include "grasp.h"
 #include "gvns.h"
+#include "mini-batch-k-means.h"
+#include "instance-io.h"
+#include "batch-runner.h"
 
 #define N_INSTANCES 5
 
-std::ostream& printKMeans(std::ostream& os, std::string instance, Problem& problem, KMeans algorithm, bool debug = false) {
-  for (int i{0}; i < N_INSTANCES; ++i) {
-    auto start = std::chrono::high_resolution_clock::now();
-    std::vector<Solution> solutions = algorithm.solve(problem, problem.size()/10 < 2 ? 2 : problem.size()/10);
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end - start;
-    os << instance << "," << problem.size() << "," << solutions[solutions.size() - 1].size() << "," << i + 1 << "," << solutions[solutions.size() - 1].evaluate(problem) << "," << elapsed_seconds.count() << std::endl;
-    if (debug) {
-      for (int j{0}; j < solutions[solutions.size() - 1].size(); ++j) {
-        for (int k{0}; k < solutions[solutions.size() - 1][j].size(); ++k) {
-          os << solutions[solutions.size() - 1][j][k] << " ";
-        } os << std::endl;
-      }
-    }
+Problem loadProblem(std::string instance_path) {
+  try {
+    return load_instance(instance_path);
+  } catch (const std::exception& error) {
+    std::cout << error.what() << std::endl;
+    throw;
   }
-  return os;
 }
 
-std::ostream& printGrasp(std::ostream& os, std::string instance, Problem& problem, Grasp algorithm, int lrc_size, bool debug = false) {
-  for (int i{0}; i < N_INSTANCES; ++i) {
-    auto start = std::chrono::high_resolution_clock::now();
-    std::vector<Solution> solutions = algorithm.solve(problem, problem.size()/10 < 2 ? 2 : problem.size()/10, lrc_size);
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end - start;
-    os << instance << "," << problem.size() << "," << solutions[solutions.size() - 1].size() << "," << lrc_size << "," << i + 1 << "," << solutions[solutions.size() - 1].evaluate(problem) << "," << elapsed_seconds.count() << std::endl;
-    if (debug) {
-      for (int j{0}; j < solutions[solutions.size() - 1].size(); ++j) {
-        for (int k{0}; k < solutions[solutions.size() - 1][j].size(); ++k) {
-          os << solutions[solutions.size() - 1][j][k] << " ";
-        } os << std::endl;
-      }
-    }
+/**
+ * @brief Converts a text instance to the binary format
+ *        Usage: --convert <input_file> <output_file> [f32]
+ */
+int runConvert(int argc, char** argv) {
+  if (argc < 4) {
+    std::cout << "Usage: " << argv[0] << " --convert <input_file> <output_file> [f32]" << std::endl;
+    return 1;
   }
-  return os;
+  Problem problem = loadProblem(argv[2]);
+  bool single = argc > 4 && std::string(argv[4]) == "f32";
+  write_binary_instance(argv[3], problem, single ? kFloat32 : kFloat64);
+  return 0;
 }
 
-std::ostream& printGVNS(std::ostream& os, std::string instance, Problem& problem, GVNS algorithm, bool rvnd = false, bool debug = false) {
-  auto start = std::chrono::high_resolution_clock::now();
-  std::vector<Solution> solutions = algorithm.solve(problem, problem.size()/10 < 2 ? 2 : problem.size()/10, rvnd);
-  auto end = std::chrono::high_resolution_clock::now();
-  std::chrono::duration<double> elapsed_seconds = end - start;
-  for (int i{0}; i < N_INSTANCES; ++i) {
-    os << instance << "," << problem.size() << "," << solutions[solutions.size() - 1].size() << "," << solutions[solutions.size() - 1].size() << "," << i + 1 << "," << solutions[solutions.size() - 1].evaluate(problem) << "," << elapsed_seconds.count() << std::endl;
-    if (debug) {
-      for (int j{0}; j < solutions[solutions.size() - 1].size(); ++j) {
-        for (int k{0}; k < solutions[solutions.size() - 1][j].size(); ++k) {
-          os << solutions[solutions.size() - 1][j][k] << " ";
-        } os << std::endl;
+/**
+ * @brief Clusters an instance that may not fit in memory, reading it in batches
+ *        Usage: --mini-batch <instance_file> [<batch_size> [<checkpoint_every> <checkpoint_file>]] [--max-clusters <k>]
+ */
+int runMiniBatch(int argc, char** argv) {
+  if (argc < 3) {
+    std::cout << "Usage: " << argv[0] << " --mini-batch <instance_file> [<batch_size> [<checkpoint_every> <checkpoint_file>]] [--max-clusters <k>]" << std::endl;
+    return 1;
+  }
+  std::string instance_path = argv[2];
+  MiniBatchKMeansOptions options;
+  options.threads = 0;
+  // Los centroides sí están todos en memoria: k se limita para instancias mayores que ella
+  int max_clusters{4096};
+  try {
+    std::vector<std::string> arguments;
+    for (int a{3}; a < argc; ++a) {
+      if (std::string(argv[a]) == "--max-clusters" && a + 1 < argc) {
+        max_clusters = std::stoi(argv[++a]);
+      } else {
+        arguments.push_back(argv[a]);
       }
     }
+    if (arguments.size() > 0) options.batch_size = std::stoi(arguments[0]);
+    if (arguments.size() > 2) {
+      options.checkpoint_every = std::stoi(arguments[1]);
+      options.checkpoint_path = arguments[2];
+    }
+  } catch (const std::exception&) {
+    std::cout << "Usage: " << argv[0] << " --mini-batch <instance_file> [<batch_size> [<checkpoint_every> <checkpoint_file>]] [--max-clusters <k>]" << std::endl;
+    return 1;
   }
-  return os;
-}
-
-Problem loadProblem(std::string instance_path) {
-  std::ifstream file(instance_path);
-  if (!file.is_open()) {
-    std::cout << "Error opening file " << instance_path << std::endl;
-    throw;
-  }
-  int m, n;
-  file >> m >> n;
-  Problem problem(m, n);
-  for (int i{0}; i < m; ++i) {
-    for (int j{0}; j < n; ++j) {
-      file >> problem[i][j];
+  try {
+    PointStream stream(instance_path);
+    MiniBatchKMeans algorithm(options);
+    int k = stream.size()/10 < 2 ? 2 : stream.size()/10;
+    if (k > max_clusters) {
+      std::cerr << "Warning: k = m/10 = " << k << " exceeds --max-clusters, using k = " << max_clusters << std::endl;
+      k = max_clusters;
     }
+    std::cout << "Algoritmo Mini-Batch K-Means" << std::endl;
+    std::cout << "Problema,m,k,|Lote|,SSE,CPU(s)" << std::endl;
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<Solution> solutions = algorithm.solve(stream, k);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << instance_path << "," << stream.size() << "," << k << "," << options.batch_size << "," << algorithm.evaluate(stream, solutions[solutions.size() - 1]) << "," << elapsed_seconds.count() << std::endl;
+  } catch (const std::exception& error) {
+    std::cout << error.what() << std::endl;
+    return 1;
   }
-  file.close();
-  return problem;
+  return 0;
+}
+
+void usage(char** argv) {
+  std::cout << "Usage: " << argv[0] << " <instance_folder> [1] [--f32] [--first-improvement] [--candidates <m>] [--time-limit <seconds>] [--trace <trace_file>]" << std::endl;
+  std::cout << "       " << argv[0] << " --mini-batch <instance_file> [<batch_size> [<checkpoint_every> <checkpoint_file>]] [--max-clusters <k>]" << std::endl;
+  std::cout << "       " << argv[0] << " --convert <input_file> <output_file> [f32]" << std::endl;
 }
 
 int main(int argc, char** argv) {
   if (argc < 2) {
-    std::cout << "Usage: " << argv[0] << " <instance_folder> [<output_file>]" << std::endl;
+    usage(argv);
     return 1;
   }
-  std::ofstream output;
-  // if (argc == 3) {
-  //   output.open(argv[2]);
-  // } else {
-  //   output.open("out.csv");
-  // }
-  bool debug = (argc == 3 && std::string(argv[2]) == "1");
+  if (std::string(argv[1]) == "--mini-batch") {
+    return runMiniBatch(argc, argv);
+  }
+  if (std::string(argv[1]) == "--convert") {
+    return runConvert(argc, argv);
+  }
+  bool debug = (argc >= 3 && std::string(argv[2]) == "1");
+  // Con make INSTRUMENT=1, traza de fases en el formato de Chrome
+  std::string trace_path;
+  bool single_precision{false};  // K-Means con los puntos en float
+  LocalSearchOptions local_search;  // Búsqueda local de GRASP y GVNS
+  std::optional<double> time_limit;  // Segundos de cada ejecución
+  try {
+    for (int a{2}; a < argc; ++a) {
+      if (std::string(argv[a]) == "--trace" && a + 1 < argc) trace_path = argv[a + 1];
+      if (std::string(argv[a]) == "--f32") single_precision = true;
+      if (std::string(argv[a]) == "--first-improvement") local_search.strategy = LocalSearchStrategy::kFirstImprovement;
+      if (std::string(argv[a]) == "--candidates" && a + 1 < argc) local_search.candidate_list_size = std::stoi(argv[a + 1]);
+      if (std::string(argv[a]) == "--time-limit" && a + 1 < argc) time_limit = std::stod(argv[a + 1]);
+    }
+  } catch (const std::exception&) {
+    usage(argv);
+    return 1;
+  }
+  instrumentation::Registry::instance().set_tracing(instrumentation::kEnabled && !trace_path.empty());
   std::string instance_folder = argv[1];
-  KMeans kmeans;
-  std::cout << "Algoritmo K-Means" << std::endl;
-  std::cout << "Problema,m,k,Ejecución,SSE,CPU(s)" << std::endl;
+  std::vector<std::string> instance_paths;
   for (const auto& entry : std::filesystem::directory_iterator(instance_folder)) {
-    std::string instance_path = entry.path();
-    Problem matrix = loadProblem(instance_path);
-    printKMeans(std::cout, instance_path, matrix, kmeans, debug);
+    instance_paths.push_back(entry.path());
   }
+  std::sort(instance_paths.begin(), instance_paths.end());
 
-  Grasp grasp;
-  std::cout << "Algoritmo GRASP" << std::endl;
-  std::cout << "Problema,m,k,|LRC|,Ejecución,SSE,CPU(s)" << std::endl;
-  for (const auto& entry : std::filesystem::directory_iterator(instance_folder)) {
-    std::string instance_path = entry.path();
-    Problem matrix = loadProblem(instance_path);
-    printGrasp(std::cout, instance_path, matrix, grasp, 3, debug);
+  BatchOptions options;
+  options.threads = 0;  // Todos los núcleos disponibles, un trabajo por hilo
+  options.repetitions = N_INSTANCES;
+  options.debug = debug;
+  options.single_precision = single_precision;
+  options.time_limit = time_limit;
+  options.kmeans.assignment = KMeansAssignment::kHamerly;
+  options.kmeans.initialization = KMeansInitialization::kPlusPlus;
+  options.grasp.local_search = local_search;
+  options.gvns.local_search = local_search;
+  BatchRunner runner(options);
+  std::cout << BatchRunner::header() << std::endl;
+  try {
+    runner.run(instance_paths, std::cout);
+  } catch (const std::exception& error) {
+    std::cout << error.what() << std::endl;
+    return 1;
   }
-
-  GVNS gvns;
-  std::cout << "Algoritmo GVNS" << std::endl;
-  std::cout << "Problema,m,k,kmax,Ejecución,SSE,CPU(s)" << std::endl;
-  for (const auto& entry : std::filesystem::directory_iterator(instance_folder)) {
-    std::string instance_path = entry.path();
-    Problem matrix = loadProblem(instance_path);
-    printGVNS(std::cout, instance_path, matrix, gvns, 3, debug);
+  if (instrumentation::kEnabled) {
+    instrumentation::write_report(std::cerr);
+    if (!trace_path.empty()) {
+      std::ofstream trace(trace_path);
+      instrumentation::Registry::instance().write_trace(trace);
+    }
   }
 
   return 0;